@@ -42,6 +42,9 @@ void register_tests_graphslam();
 void register_tests_CObservation3DRangeScan();
 void register_tests_atan2lut();
 void register_tests_strings();
+void register_tests_pf();
+void register_tests_velodyne();
+void register_tests_serialization();
 // -------------------------------------------------
 
 using TestFunctor =
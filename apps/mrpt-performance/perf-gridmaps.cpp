@@ -171,6 +171,155 @@ double grid_test_8(int a1, int a2)
 	return tictac.Tac() / N;
 }
 
+double grid_test_10(int a1, int a2)
+{
+	// test 10: Likelihood of one scan for a set of particles
+	// a1: 0=one call per particle, 1=batch call, 2=batch call in static map
+	// mode (distance transform).
+	// a2: number of particles.
+	// ----------------------------------------
+	getRandomGenerator().randomize(333);
+
+	// prepare the laser scan:
+	CObservation2DRangeScan scan1;
+	scan1.aperture = M_PIf;
+	scan1.rightToLeft = true;
+	scan1.loadFromVectors(
+		sizeof(SCAN_RANGES_1) / sizeof(SCAN_RANGES_1[0]), SCAN_RANGES_1,
+		SCAN_VALID_1);
+
+	COccupancyGridMap2D gridmap(-20, 20, -20, 20, 0.05f);
+	gridmap.likelihoodOptions.likelihoodMethod =
+		COccupancyGridMap2D::lmLikelihoodField_Thrun;
+	gridmap.likelihoodOptions.LF_decimation = 1;  // Use all the rays
+
+	CPose3D pose3D(0, 0, 0);
+	gridmap.insertObservation(&scan1, &pose3D);
+	if (a1 == 2)
+		gridmap.precomputeDistanceTransform();
+	else
+		gridmap.precomputeLikelihoodFieldCache();
+
+	std::vector<mrpt::math::TPose2D> poses(a2);
+	for (auto& p : poses)
+		p = mrpt::math::TPose2D(
+			getRandomGenerator().drawUniform(-1.0, 1.0),
+			getRandomGenerator().drawUniform(-1.0, 1.0),
+			getRandomGenerator().drawUniform(-M_PI, M_PI));
+
+	const long N = 20;
+	std::vector<double> liks;
+	double R = 0;
+	CTicTac tictac;
+	for (long i = 0; i < N; i++)
+	{
+		if (a1 == 0)
+		{
+			for (const auto& p : poses)
+				R += gridmap.computeObservationLikelihood(
+					&scan1, CPose3D(CPose2D(p)));
+		}
+		else
+		{
+			gridmap.computeObservationLikelihoodBatch(&scan1, poses, liks);
+			R += liks[0];
+		}
+	}
+	return tictac.Tac() / N;
+}
+
+double grid_test_11(int a1, int a2)
+{
+	// test 11: Build the likelihood field for the whole map
+	// a1: 0=likelihood cache, 1=distance transform (static map mode).
+	// ----------------------------------------
+	CObservation2DRangeScan scan1;
+	scan1.aperture = M_PIf;
+	scan1.rightToLeft = true;
+	scan1.loadFromVectors(
+		sizeof(SCAN_RANGES_1) / sizeof(SCAN_RANGES_1[0]), SCAN_RANGES_1,
+		SCAN_VALID_1);
+
+	COccupancyGridMap2D gridmap(-20, 20, -20, 20, 0.05f);
+	gridmap.likelihoodOptions.likelihoodMethod =
+		COccupancyGridMap2D::lmLikelihoodField_Thrun;
+
+	CPose3D pose3D(0, 0, 0);
+	gridmap.insertObservation(&scan1, &pose3D);
+
+	const long N = 5;
+	double T = 0;
+	CTicTac tictac;
+	for (long i = 0; i < N; i++)
+	{
+		// Modify the map, which discards the previous field:
+		gridmap.insertObservation(&scan1, &pose3D);
+
+		tictac.Tic();
+		if (a1 == 0)
+			gridmap.precomputeLikelihoodFieldCache();
+		else
+			gridmap.precomputeDistanceTransform();
+		T += tictac.Tac();
+	}
+	return T / N;
+}
+
+double grid_test_12(int a1, int a2)
+{
+	// test 12: Simulate a scan from a set of poses
+	// a1: 0=laserScanSimulator() per pose, 1=laserScanSimulatorBatch(),
+	// 2=laserScanSimulatorBatch() with a ray casting LUT.
+	// a2: number of poses.
+	// ----------------------------------------
+	getRandomGenerator().randomize(333);
+
+	CObservation2DRangeScan scan1;
+	scan1.aperture = M_PIf;
+	scan1.rightToLeft = true;
+	scan1.loadFromVectors(
+		sizeof(SCAN_RANGES_1) / sizeof(SCAN_RANGES_1[0]), SCAN_RANGES_1,
+		SCAN_VALID_1);
+
+	// A small map and range, so the LUT (2 bytes per cell and direction)
+	// stays small:
+	const float maxRange = 10.0f;
+	COccupancyGridMap2D gridmap(-10, 10, -10, 10, 0.1f);
+	CPose3D pose3D(0, 0, 0);
+	gridmap.insertObservation(&scan1, &pose3D);
+	if (a1 == 2) gridmap.precomputeRayCastLUT(360, maxRange);
+
+	std::vector<mrpt::math::TPose2D> poses(a2);
+	for (auto& p : poses)
+		p = mrpt::math::TPose2D(
+			getRandomGenerator().drawUniform(-1.0, 1.0),
+			getRandomGenerator().drawUniform(-1.0, 1.0),
+			getRandomGenerator().drawUniform(-M_PI, M_PI));
+
+	CObservation2DRangeScan simul;
+	simul.aperture = M_PIf;
+	simul.maxRange = maxRange;
+	std::vector<float> ranges;
+	std::vector<char> valids;
+
+	const long N = 5;
+	CTicTac tictac;
+	for (long i = 0; i < N; i++)
+	{
+		if (a1 == 0)
+		{
+			for (const auto& p : poses)
+				gridmap.laserScanSimulator(simul, CPose2D(p), 0.6f, 361);
+		}
+		else
+		{
+			gridmap.laserScanSimulatorBatch(
+				simul, poses, ranges, valids, 0.6f, 361);
+		}
+	}
+	return tictac.Tac() / N;
+}
+
 double grid_test_9(int a1, int a2)
 {
 	// test 9: computeMatchingWith2D
@@ -229,6 +378,41 @@ void register_tests_grids()
 		TestData("gridmap2D: insert scan with widening", grid_test_5_6, 1));
 	lstTests.push_back(TestData("gridmap2D: resize", grid_test_7));
 	lstTests.push_back(TestData("gridmap2D: computeLikelihood", grid_test_8));
+	lstTests.push_back(
+		TestData(
+			"gridmap2D: LF_Thrun likelihood, 1000 particles x 361 rays "
+			"(per particle)",
+			grid_test_10, 0, 1000));
+	lstTests.push_back(
+		TestData(
+			"gridmap2D: LF_Thrun likelihood, 1000 particles x 361 rays "
+			"(batch)",
+			grid_test_10, 1, 1000));
+	lstTests.push_back(
+		TestData(
+			"gridmap2D: LF_Thrun likelihood, 1000 particles x 361 rays "
+			"(batch, static map mode)",
+			grid_test_10, 2, 1000));
+	lstTests.push_back(
+		TestData(
+			"gridmap2D: build LF_Thrun likelihood cache (800x800)",
+			grid_test_11, 0));
+	lstTests.push_back(
+		TestData(
+			"gridmap2D: build distance transform (800x800)", grid_test_11,
+			1));
+	lstTests.push_back(
+		TestData(
+			"gridmap2D: simulate 1000 scans x 361 rays (per scan)",
+			grid_test_12, 0, 1000));
+	lstTests.push_back(
+		TestData(
+			"gridmap2D: simulate 1000 scans x 361 rays (batch)", grid_test_12,
+			1, 1000));
+	lstTests.push_back(
+		TestData(
+			"gridmap2D: simulate 1000 scans x 361 rays (batch, LUT)",
+			grid_test_12, 2, 1000));
 	lstTests.push_back(
 		TestData("gridmap2D: determineMatching2D", grid_test_9, 5000));
 }
@@ -219,6 +219,9 @@ int main(int argc, char** argv)
 		register_tests_CObservation3DRangeScan();
 		register_tests_atan2lut();
 		register_tests_strings();
+		register_tests_pf();
+		register_tests_velodyne();
+		register_tests_serialization();
 
 		if (doLog)
 		{
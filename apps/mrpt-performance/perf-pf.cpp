@@ -0,0 +1,110 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/bayes/CParticleFilter.h>
+#include <mrpt/maps/COccupancyGridMap2D.h>
+#include <mrpt/obs/CActionCollection.h>
+#include <mrpt/obs/CActionRobotMovement2D.h>
+#include <mrpt/obs/CObservation2DRangeScan.h>
+#include <mrpt/obs/CSensoryFrame.h>
+#include <mrpt/slam/CMonteCarloLocalization2D.h>
+#include <mrpt/random.h>
+
+#include "common.h"
+
+using namespace mrpt;
+using namespace mrpt::bayes;
+using namespace mrpt::maps;
+using namespace mrpt::obs;
+using namespace mrpt::poses;
+using namespace mrpt::random;
+using namespace mrpt::slam;
+using namespace std;
+
+// ------------------------------------------------------
+//				Benchmark Particle Filters
+// ------------------------------------------------------
+// a1: number of particles, a2: number of threads
+double pf_test_mcl2d(int a1, int a2)
+{
+	getRandomGenerator().randomize(333);
+
+	// prepare the map: the laser scan inserted from several poses:
+	CObservation2DRangeScan::Ptr scan1 =
+		mrpt::make_aligned_shared<CObservation2DRangeScan>();
+	scan1->aperture = M_PIf;
+	scan1->rightToLeft = true;
+	scan1->loadFromVectors(
+		sizeof(SCAN_RANGES_1) / sizeof(SCAN_RANGES_1[0]), SCAN_RANGES_1,
+		SCAN_VALID_1);
+
+	COccupancyGridMap2D gridmap(-20, 20, -20, 20, 0.05f);
+	for (int i = 0; i < 5; i++)
+	{
+		const CPose3D pose3D(0.1 * i, 0, 0);
+		gridmap.insertObservation(scan1.get(), &pose3D);
+	}
+	gridmap.likelihoodOptions.likelihoodMethod =
+		COccupancyGridMap2D::lmLikelihoodField_Thrun;
+
+	CSensoryFrame sf;
+	sf.insert(scan1);
+
+	CActionRobotMovement2D odo;
+	odo.computeFromOdometry(
+		CPose2D(0.1, 0, 0.01), CActionRobotMovement2D::TMotionModelOptions());
+	CActionCollection acts;
+	acts.insert(odo);
+
+	CMonteCarloLocalization2D pdf;
+	pdf.options.metricMap = &gridmap;
+	pdf.resetUniform(-1, 1, -1, 1, -M_PI, M_PI, a1);
+
+	CParticleFilter PF;
+	PF.m_options.numThreads = a2;
+
+	// Warm-up the likelihood cache of the grid:
+	PF.executeOn(pdf, &acts, &sf);
+
+	const long N = 10;
+	CTicTac tictac;
+	for (long i = 0; i < N; i++) PF.executeOn(pdf, &acts, &sf);
+	return tictac.Tac() / N;
+}
+
+// ------------------------------------------------------
+// register_tests_pf
+// ------------------------------------------------------
+void register_tests_pf()
+{
+	lstTests.push_back(TestData(
+		"pf: MCL2D step (1000 particles, 1 thread)", pf_test_mcl2d, 1000, 1));
+	lstTests.push_back(TestData(
+		"pf: MCL2D step (1000 particles, 2 threads)", pf_test_mcl2d, 1000, 2));
+	lstTests.push_back(TestData(
+		"pf: MCL2D step (1000 particles, 4 threads)", pf_test_mcl2d, 1000, 4));
+	lstTests.push_back(TestData(
+		"pf: MCL2D step (1000 particles, 8 threads)", pf_test_mcl2d, 1000, 8));
+	lstTests.push_back(TestData(
+		"pf: MCL2D step (5000 particles, 1 thread)", pf_test_mcl2d, 5000, 1));
+	lstTests.push_back(TestData(
+		"pf: MCL2D step (5000 particles, 2 threads)", pf_test_mcl2d, 5000, 2));
+	lstTests.push_back(TestData(
+		"pf: MCL2D step (5000 particles, 4 threads)", pf_test_mcl2d, 5000, 4));
+	lstTests.push_back(TestData(
+		"pf: MCL2D step (5000 particles, 8 threads)", pf_test_mcl2d, 5000, 8));
+	lstTests.push_back(TestData(
+		"pf: MCL2D step (20000 particles, 1 thread)", pf_test_mcl2d, 20000, 1));
+	lstTests.push_back(TestData(
+		"pf: MCL2D step (20000 particles, 4 threads)", pf_test_mcl2d, 20000,
+		4));
+	lstTests.push_back(TestData(
+		"pf: MCL2D step (20000 particles, 8 threads)", pf_test_mcl2d, 20000,
+		8));
+}
@@ -8,9 +8,14 @@
    +------------------------------------------------------------------------+ */
 
 #include <mrpt/obs/CObservation2DRangeScan.h>
+#include <mrpt/obs/CActionRobotMovement2D.h>
+#include <mrpt/obs/CRawlog.h>
 #include <mrpt/maps/CSimplePointsMap.h>
+#include <mrpt/io/CFileGZInputStream.h>
+#include <mrpt/serialization/CArchive.h>
 #include <mrpt/poses/CPose2D.h>
 #include <mrpt/random.h>
+#include <mrpt/system/filesystem.h>
 
 #include "common.h"
 
@@ -19,6 +24,7 @@ using namespace mrpt::maps;
 using namespace mrpt::obs;
 using namespace mrpt::random;
 using namespace mrpt::poses;
+using namespace mrpt::tfest;
 using namespace std;
 
 // ------------------------------------------------------
@@ -280,6 +286,114 @@ double pointmap_test_5(int a1, int a2)
 	return tictac.Tac() / a2;
 }
 
+double pointmap_test_6(int a1, int a2)
+{
+	// test 6: grow a map with all the scans of an ICP-SLAM dataset (at their
+	// odometry poses), querying the KD-tree after each insertion, as
+	// CMetricMapBuilderICP does after each keyframe.
+	// a1: 0=rebuild KD-tree after each scan, 1=incremental KD-tree.
+	// a2: 2=2D KD-tree, 3=3D KD-tree.
+	// ----------------------------------------
+#ifdef MRPT_DATASET_DIR
+	const string rawlog_file = MRPT_DATASET_DIR
+		"/2006-01ENE-21-SENA_Telecom Faculty_one_loop_only.rawlog";
+	if (!mrpt::system::fileExists(rawlog_file)) return 1;
+
+	// Load all scans and their odometry poses first:
+	std::vector<CObservation2DRangeScan::Ptr> scans;
+	std::vector<CPose3D> poses;
+	{
+		mrpt::io::CFileGZInputStream f(rawlog_file);
+		auto arch = mrpt::serialization::archiveFrom(f);
+		CActionCollection::Ptr acts;
+		CSensoryFrame::Ptr sf;
+		size_t rawlogEntry = 0;
+		CPose2D odo;
+		while (CRawlog::readActionObservationPair(
+			arch, acts, sf, rawlogEntry))
+		{
+			CPose2D incr;
+			auto mov = acts->getBestMovementEstimation();
+			if (mov) mov->poseChange->getMean(incr);
+			odo = odo + incr;
+			auto scan = sf->getObservationByClass<CObservation2DRangeScan>();
+			if (!scan) continue;
+			scans.push_back(scan);
+			poses.push_back(CPose3D(odo));
+		}
+	}
+	if (scans.empty()) return 1;
+
+	CSimplePointsMap pt_map;
+	pt_map.insertionOptions.minDistBetweenLaserPoints = 0.03f;
+	pt_map.kdtree_search_params.incremental = (a1 != 0);
+
+	CTicTac tictac;
+	for (size_t i = 0; i < scans.size(); i++)
+	{
+		pt_map.insertObservation(scans[i].get(), &poses[i]);
+
+		const float qx = poses[i].x() + 1.0f, qy = poses[i].y();
+		float x, y, z, dist2;
+		if (a2 == 2)
+			pt_map.kdTreeClosestPoint2D(qx, qy, x, y, dist2);
+		else
+			pt_map.kdTreeClosestPoint3D(qx, qy, 0.0f, x, y, z, dist2);
+	}
+	return tictac.Tac() / scans.size();
+#else
+	return 1;
+#endif
+}
+
+double pointmap_test_7(int a1, int a2)
+{
+	// test 7: correspondences between two 100k points clouds, as in one
+	// iteration of 3D ICP.
+	// a1: number of threads (0=one per core)
+	// a2: 2=determineMatching2D, 3=determineMatching3D
+	// ----------------------------------------
+	auto& rng = getRandomGenerator();
+	rng.randomize(333);
+	CSimplePointsMap globalMap, localMap;
+	const size_t N = 100000;
+	globalMap.reserve(N);
+	localMap.reserve(N);
+	for (size_t i = 0; i < N; i++)
+	{
+		globalMap.insertPointFast(
+			rng.drawUniform(-50.f, 50.f), rng.drawUniform(-50.f, 50.f),
+			rng.drawUniform(-2.f, 2.f));
+		localMap.insertPointFast(
+			rng.drawUniform(-50.f, 50.f), rng.drawUniform(-50.f, 50.f),
+			rng.drawUniform(-2.f, 2.f));
+	}
+	const CPose3D pose(0.1, 0.2, 0, 0.05, 0, 0);
+
+	TMatchingParams params;
+	params.maxDistForCorrespondence = 0.5f;
+	params.numThreads = a1;
+	TMatchingPairList corrs;
+	TMatchingExtraResults extra;
+	// Build the KD-tree out of the timed loop:
+	globalMap.determineMatching3D(&localMap, pose, corrs, params, extra);
+	globalMap.determineMatching2D(
+		&localMap, CPose2D(pose), corrs, params, extra);
+
+	const long T = 10;
+	CTicTac tictac;
+	for (long i = 0; i < T; i++)
+	{
+		if (a2 == 3)
+			globalMap.determineMatching3D(
+				&localMap, pose, corrs, params, extra);
+		else
+			globalMap.determineMatching2D(
+				&localMap, CPose2D(pose), corrs, params, extra);
+	}
+	return tictac.Tac() / T;
+}
+
 // ------------------------------------------------------
 // register_tests_pointmaps
 // ------------------------------------------------------
@@ -353,4 +467,40 @@ void register_tests_pointmaps()
 	lstTests.push_back(
 		TestData(
 			"pointmap: boundingBox (1000 scans)", pointmap_test_5, 1000, 5000));
+
+	lstTests.push_back(
+		TestData(
+			"pointmap: grow map from dataset, 2D kd-tree rebuild (per scan)",
+			pointmap_test_6, 0, 2));
+	lstTests.push_back(
+		TestData(
+			"pointmap: grow map from dataset, 2D kd-tree incremental (per "
+			"scan)",
+			pointmap_test_6, 1, 2));
+	lstTests.push_back(
+		TestData(
+			"pointmap: grow map from dataset, 3D kd-tree rebuild (per scan)",
+			pointmap_test_6, 0, 3));
+	lstTests.push_back(
+		TestData(
+			"pointmap: grow map from dataset, 3D kd-tree incremental (per "
+			"scan)",
+			pointmap_test_6, 1, 3));
+
+	lstTests.push_back(
+		TestData(
+			"pointmap: determineMatching2D 100k pts, 1 thread",
+			pointmap_test_7, 1, 2));
+	lstTests.push_back(
+		TestData(
+			"pointmap: determineMatching2D 100k pts, all cores",
+			pointmap_test_7, 0, 2));
+	lstTests.push_back(
+		TestData(
+			"pointmap: determineMatching3D 100k pts, 1 thread",
+			pointmap_test_7, 1, 3));
+	lstTests.push_back(
+		TestData(
+			"pointmap: determineMatching3D 100k pts, all cores",
+			pointmap_test_7, 0, 3));
 }
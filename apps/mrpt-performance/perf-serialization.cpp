@@ -0,0 +1,171 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/maps/CSimplePointsMap.h>
+#include <mrpt/math/CMatrix.h>
+#include <mrpt/obs/CObservation3DRangeScan.h>
+#include <mrpt/io/CMemoryStream.h>
+#include <mrpt/io/CMemoryMappedFile.h>
+#include <mrpt/serialization/CArchive.h>
+#include <mrpt/random.h>
+#include <mrpt/system/filesystem.h>
+
+#include "common.h"
+
+using namespace mrpt;
+using namespace mrpt::maps;
+using namespace mrpt::math;
+using namespace mrpt::obs;
+using namespace mrpt::random;
+using namespace std;
+
+// All the tests below return the time per MB of serialized data, so the
+// reported rate (Hz) is the throughput in MB/s.
+
+// a1: 0=CSimplePointsMap, 1=CMatrix, 2=CObservation3DRangeScan
+static CSerializable::Ptr makeBigObject(int a1)
+{
+	auto& rng = getRandomGenerator();
+	rng.randomize(123);
+	switch (a1)
+	{
+		case 0:
+		{
+			auto m = mrpt::make_aligned_shared<CSimplePointsMap>();
+			const size_t N = 1000000;
+			m->reserve(N);
+			for (size_t i = 0; i < N; i++)
+				m->insertPointFast(
+					rng.drawUniform(-50.f, 50.f), rng.drawUniform(-50.f, 50.f),
+					rng.drawUniform(-5.f, 5.f));
+			return m;
+		}
+		case 1:
+		{
+			auto m = mrpt::make_aligned_shared<CMatrix>(1000, 1000);
+			rng.drawGaussian1DMatrix(*m);
+			return m;
+		}
+		case 2:
+		{
+			auto o = mrpt::make_aligned_shared<CObservation3DRangeScan>();
+			const int W = 640, H = 480;
+			o->hasRangeImage = true;
+			o->rangeImage.setSize(H, W);
+			rng.drawUniformMatrix(o->rangeImage, 0.5f, 5.0f);
+			o->hasPoints3D = true;
+			o->resizePoints3DVectors(W * H);
+			for (int i = 0; i < W * H; i++)
+			{
+				o->points3D_x[i] = o->rangeImage(i / W, i % W);
+				o->points3D_y[i] = o->points3D_z[i] = 0.1f * (i % W);
+				o->points3D_idxs_x[i] = i % W;
+				o->points3D_idxs_y[i] = i / W;
+			}
+			return o;
+		}
+	};
+	THROW_EXCEPTION("Unknown object type");
+}
+
+static double timePerMB(double t, uint64_t nBytes)
+{
+	return t / (nBytes / (1024.0 * 1024.0));
+}
+
+// a1: object type
+double serialization_write_memory(int a1, int)
+{
+	const auto obj = makeBigObject(a1);
+
+	const long N = 10;
+	uint64_t nBytes = 0;
+	CTicTac tictac;
+	for (long i = 0; i < N; i++)
+	{
+		mrpt::io::CMemoryStream buf;
+		auto arch = mrpt::serialization::archiveFrom(buf);
+		arch << *obj;
+		nBytes += buf.getTotalBytesCount();
+	}
+	return timePerMB(tictac.Tac(), nBytes);
+}
+
+// a1: object type. a2: 0=read from a CMemoryStream, 1=from a memory-mapped
+// file
+double serialization_read_memory(int a1, int a2)
+{
+	const auto obj = makeBigObject(a1);
+
+	mrpt::io::CMemoryStream buf;
+	auto arch = mrpt::serialization::archiveFrom(buf);
+	arch << *obj;
+
+	const std::string fil = mrpt::system::getTempFileName();
+	mrpt::io::CMemoryMappedFile mmf;
+	mrpt::io::CMemoryStream in;
+	if (a2 == 0)
+		in.assignMemoryNotOwn(buf.getRawBufferData(), buf.getTotalBytesCount());
+	else
+	{
+		ASSERT_(buf.saveBufferToFile(fil));
+		ASSERT_(mmf.open(fil));
+		in.assignMemoryNotOwn(mmf.data(), mmf.size());
+	}
+	auto arch_in = mrpt::serialization::archiveFrom(in);
+
+	const long N = 10;
+	CSerializable::Ptr obj2;
+	CTicTac tictac;
+	for (long i = 0; i < N; i++)
+	{
+		in.Seek(0);
+		arch_in >> obj2;
+	}
+	const double t = timePerMB(tictac.Tac(), N * buf.getTotalBytesCount());
+
+	mmf.close();
+	mrpt::system::deleteFile(fil);
+	return t;
+}
+
+// ------------------------------------------------------
+// register_tests_serialization
+// ------------------------------------------------------
+void register_tests_serialization()
+{
+	lstTests.push_back(TestData(
+		"serialization: write CSimplePointsMap 1M pts (per MB)",
+		serialization_write_memory, 0));
+	lstTests.push_back(TestData(
+		"serialization: read CSimplePointsMap 1M pts, memory (per MB)",
+		serialization_read_memory, 0, 0));
+	lstTests.push_back(TestData(
+		"serialization: read CSimplePointsMap 1M pts, mmap (per MB)",
+		serialization_read_memory, 0, 1));
+	lstTests.push_back(TestData(
+		"serialization: write CMatrix 1000x1000 (per MB)",
+		serialization_write_memory, 1));
+	lstTests.push_back(TestData(
+		"serialization: read CMatrix 1000x1000, memory (per MB)",
+		serialization_read_memory, 1, 0));
+	lstTests.push_back(TestData(
+		"serialization: read CMatrix 1000x1000, mmap (per MB)",
+		serialization_read_memory, 1, 1));
+	lstTests.push_back(TestData(
+		"serialization: write CObservation3DRangeScan 640x480 (per MB)",
+		serialization_write_memory, 2));
+	lstTests.push_back(TestData(
+		"serialization: read CObservation3DRangeScan 640x480, memory (per "
+		"MB)",
+		serialization_read_memory, 2, 0));
+	lstTests.push_back(TestData(
+		"serialization: read CObservation3DRangeScan 640x480, mmap (per MB)",
+		serialization_read_memory, 2, 1));
+}
@@ -0,0 +1,148 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/obs/CObservationVelodyneScan.h>
+#include <mrpt/poses/CPose3DInterpolator.h>
+#include <mrpt/io/CFileInputStream.h>
+#include <mrpt/system/filesystem.h>
+#include <cstring>
+
+#include "common.h"
+
+using namespace mrpt;
+using namespace mrpt::obs;
+using namespace mrpt::io;
+using namespace std;
+
+const string velodyne_test_pcap_files[] = {
+#ifdef MRPT_TESTS_DIR
+	MRPT_TESTS_DIR "/sample_velodyne_hdl32.pcap",
+	MRPT_TESTS_DIR "/sample_velodyne_vlp16_gps.pcap"
+#else
+	"", ""
+#endif
+};
+
+// Loads all the DATA packets of a pcap file into one scan. A minimal pcap
+// parser is used so this does not depend on libpcap: a 24 bytes global
+// header, then 16 bytes per record header, followed by the Ethernet+IP+UDP
+// headers (42 bytes) and the UDP payload.
+static void loadVelodynePcap(
+	const string& fil, const string& model, CObservationVelodyneScan& scan)
+{
+	ASSERTMSG_(
+		mrpt::system::fileExists(fil),
+		mrpt::format("Missing dataset file: %s", fil.c_str()));
+
+	scan.calibration = VelodyneCalibration::LoadDefaultCalibration(model);
+	scan.timestamp = mrpt::system::now();
+	scan.minRange = 1.0;
+	scan.maxRange = 130.0;
+	scan.scan_packets.clear();
+
+	CFileInputStream f(fil);
+	uint8_t global_hdr[24];
+	ASSERT_(f.Read(global_hdr, sizeof(global_hdr)) == sizeof(global_hdr));
+
+	const size_t UDP_HDR_SIZE = 42;
+	std::vector<uint8_t> buf;
+	for (;;)
+	{
+		uint32_t rec_hdr[4];  // ts_sec, ts_usec, incl_len, orig_len
+		if (f.Read(rec_hdr, sizeof(rec_hdr)) != sizeof(rec_hdr)) break;
+		buf.resize(rec_hdr[2]);
+		if (f.Read(buf.data(), buf.size()) != buf.size()) break;
+		if (buf.size() !=
+			UDP_HDR_SIZE + CObservationVelodyneScan::PACKET_SIZE)
+			continue;  // Not a DATA packet
+		CObservationVelodyneScan::TVelodyneRawPacket pkt;
+		std::memcpy(&pkt, &buf[UDP_HDR_SIZE], sizeof(pkt));
+		scan.scan_packets.push_back(pkt);
+	}
+	ASSERT_(!scan.scan_packets.empty());
+}
+
+// ------------------------------------------------------
+//				Benchmark Velodyne decoding
+// ------------------------------------------------------
+// a1: 0=HDL-32, 1=VLP-16 dataset. a2: number of threads
+double velodyne_generatePointCloud(int a1, int a2)
+{
+	CObservationVelodyneScan scan;
+	loadVelodynePcap(
+		velodyne_test_pcap_files[a1], a1 == 0 ? "HDL32" : "VLP16", scan);
+
+	CObservationVelodyneScan::TGeneratePointCloudParameters p;
+	p.numThreads = a2;
+
+	// Warm-up (and allocate the output buffers):
+	scan.generatePointCloud(p);
+
+	const long N = 20;
+	CTicTac tictac;
+	for (long i = 0; i < N; i++) scan.generatePointCloud(p);
+	return tictac.Tac() / N;
+}
+
+// a1: 0=HDL-32, 1=VLP-16 dataset. a2: number of threads
+double velodyne_generatePointCloudAlongSE3Trajectory(int a1, int a2)
+{
+	CObservationVelodyneScan scan;
+	loadVelodynePcap(
+		velodyne_test_pcap_files[a1], a1 == 0 ? "HDL32" : "VLP16", scan);
+
+	mrpt::poses::CPose3DInterpolator path;
+	path.insert(
+		mrpt::system::timestampAdd(scan.timestamp, -1.0),
+		mrpt::math::TPose3D(0, 0, 0, 0, 0, 0));
+	path.insert(
+		mrpt::system::timestampAdd(scan.timestamp, 10.0),
+		mrpt::math::TPose3D(20.0, 1.0, 0, 0.4, 0, 0));
+
+	CObservationVelodyneScan::TGeneratePointCloudParameters p;
+	p.numThreads = a2;
+
+	const long N = 10;
+	std::vector<mrpt::math::TPointXYZIu8> pts;
+	CTicTac tictac;
+	for (long i = 0; i < N; i++)
+	{
+		pts.clear();
+		CObservationVelodyneScan::TGeneratePointCloudSE3Results res;
+		scan.generatePointCloudAlongSE3Trajectory(path, pts, res, p);
+	}
+	return tictac.Tac() / N;
+}
+
+// ------------------------------------------------------
+// register_tests_velodyne
+// ------------------------------------------------------
+void register_tests_velodyne()
+{
+	lstTests.push_back(TestData(
+		"velodyne: generatePointCloud HDL-32 pcap (1 thread)",
+		velodyne_generatePointCloud, 0, 1));
+	lstTests.push_back(TestData(
+		"velodyne: generatePointCloud HDL-32 pcap (4 threads)",
+		velodyne_generatePointCloud, 0, 4));
+	lstTests.push_back(TestData(
+		"velodyne: generatePointCloud VLP-16 pcap (1 thread)",
+		velodyne_generatePointCloud, 1, 1));
+	lstTests.push_back(TestData(
+		"velodyne: generatePointCloud VLP-16 pcap (4 threads)",
+		velodyne_generatePointCloud, 1, 4));
+	lstTests.push_back(TestData(
+		"velodyne: generatePointCloudAlongSE3Trajectory HDL-32 pcap (1 "
+		"thread)",
+		velodyne_generatePointCloudAlongSE3Trajectory, 0, 1));
+	lstTests.push_back(TestData(
+		"velodyne: generatePointCloudAlongSE3Trajectory HDL-32 pcap (4 "
+		"threads)",
+		velodyne_generatePointCloudAlongSE3Trajectory, 0, 4));
+}
@@ -0,0 +1,61 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include "rawlog-edit-declarations.h"
+#include <mrpt/obs/CRawlogIndex.h>
+#include <mrpt/system/CTicTac.h>
+
+using namespace mrpt;
+using namespace mrpt::obs;
+using namespace mrpt::system;
+using namespace std;
+using namespace mrpt::io;
+
+// ======================================================================
+//		op_build_index
+// ======================================================================
+DECLARE_OP_FUNCTION(op_build_index)
+{
+	// The index is built from the file name, not from the already open
+	// stream:
+	in_rawlog.close();
+
+	string inFile;
+	getArgValue<string>(cmdline, "input", inFile);
+
+	string idxFile;
+	if (!getArgValue<string>(cmdline, "output", idxFile) || idxFile.empty())
+		idxFile = CRawlogIndex::defaultIndexFileName(inFile);
+
+	if (mrpt::system::fileExists(idxFile) && !isFlagSet(cmdline, "overwrite"))
+		throw runtime_error(
+			format(
+				"*ABORTING*: Output file `%s` already exists. Use -w to "
+				"overwrite it.",
+				idxFile.c_str()));
+
+	VERBOSE_COUT << "Writing index to: " << idxFile << endl;
+
+	CTicTac tictac;
+	const bool ok = CRawlogIndex::build(
+		inFile, idxFile, [verbose](size_t nEntries, uint64_t nBytes) {
+			if (verbose && (nEntries % 10000) == 0)
+				cout << "[rawlog-edit] Entries: " << nEntries << " ("
+					 << unitsFormat(nBytes) << "B)\r" << std::flush;
+		});
+	if (!ok)
+		throw runtime_error(
+			format("Error building the index of `%s`", inFile.c_str()));
+
+	CRawlogIndex idx;
+	ASSERT_(idx.open(idxFile));
+	VERBOSE_COUT << "Indexed " << idx.size() << " entries ("
+				 << idx.sortedByTimeSize() << " with timestamps) in "
+				 << tictac.Tac() << " s.\n";
+}
@@ -67,6 +67,7 @@ DECLARE_OP_FUNCTION(op_stereo_rectify);
 DECLARE_OP_FUNCTION(op_rename_externals);
 DECLARE_OP_FUNCTION(op_list_timestamps);
 DECLARE_OP_FUNCTION(op_remap_timestamps);
+DECLARE_OP_FUNCTION(op_build_index);
 
 // Declare the supported command line switches ===========
 TCLAP::CmdLine cmd(
@@ -454,6 +455,17 @@ int main(int argc, char** argv)
 				cmd, false));
 		ops_functors["rename-externals"] = &op_rename_externals;
 
+		arg_ops.push_back(
+			new TCLAP::SwitchArg(
+				"", "build-index",
+				"Op: Builds the sidecar index of the rawlog, which allows "
+				"opening it for random access without loading it into memory "
+				"(see CRawlog::loadFromRawLogFileLazy()).\n"
+				"Optional: -o to change the index file name (default: "
+				"<input>.idx), -w to overwrite an existing one.\n",
+				cmd, false));
+		ops_functors["build-index"] = &op_build_index;
+
 		// --------------- End of list of possible operations --------
 
 		// Parse arguments:
@@ -165,6 +165,25 @@ class CParticleFilter : public mrpt::system::COutputLogger
 		 * perform rejection sampling, but just the most-likely (ML) particle
 		 * found in the preliminary weight-determination stage. */
 		bool pfAuxFilterOptimal_MLE;
+
+		/** (Default=1) Number of threads used to draw the new particles from
+		 * the motion model and to evaluate the observation likelihood of
+		 * each particle. 1 means sequential processing in the calling thread,
+		 * 0 means one thread per hardware core.
+		 *
+		 * For any numThreads!=1, each block of particles draws its random
+		 * samples from its own mrpt::random::CRandomGenerator seeded from the
+		 * global one, so results are reproducible for a given seed and do not
+		 * depend on the number of threads. They do differ from those of
+		 * numThreads=1, which keeps using the global generator sequentially.
+		 * Observation likelihoods are only evaluated in parallel if the PDF
+		 * supports it, e.g. see the list of supported maps in
+		 * mrpt::slam::TMonteCarloLocalizationParams.
+		 * Currently used by mrpt::slam::PF_implementation (e.g.
+		 * mrpt::slam::CMonteCarloLocalization2D) in the pfStandardProposal,
+		 * pfAuxiliaryPFStandard and pfAuxiliaryPFOptimal algorithms.
+		 */
+		unsigned int numThreads;
 	};
 
 	/** Statistics for being returned from the "execute" method. */
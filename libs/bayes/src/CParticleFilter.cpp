@@ -110,7 +110,8 @@ CParticleFilter::TParticleFilterOptions::TParticleFilterOptions()
 	  resamplingMethod(prMultinomial),
 	  max_loglikelihood_dyn_range(15),
 	  pfAuxFilterStandard_FirstStageWeightsMonteCarlo(false),
-	  pfAuxFilterOptimal_MLE(false)
+	  pfAuxFilterOptimal_MLE(false),
+	  numThreads(1)
 {
 }
 
@@ -148,6 +149,10 @@ void CParticleFilter::TParticleFilterOptions::saveToConfigFile(
 		pfAuxFilterStandard_FirstStageWeightsMonteCarlo,
 		"Only for PF_algorithm==pfAuxiliaryPFStandard");
 	MRPT_SAVE_CONFIG_VAR_COMMENT(pfAuxFilterOptimal_MLE, "See doxygen docs.");
+	MRPT_SAVE_CONFIG_VAR_COMMENT(
+		numThreads,
+		"Number of threads for particle prediction & weighting (1: no "
+		"parallelization, 0: one per hardware core)");
 }
 
 /*---------------------------------------------------------------
@@ -190,6 +195,10 @@ void CParticleFilter::TParticleFilterOptions::loadFromConfigFile(
 		section.c_str());
 	MRPT_LOAD_CONFIG_VAR(
 		pfAuxFilterOptimal_MLE, bool, iniFile, section.c_str());
+	const int nThreads =
+		iniFile.read_int(section, "numThreads", static_cast<int>(numThreads));
+	ASSERT_(nThreads >= 0);
+	numThreads = static_cast<unsigned int>(nThreads);
 
 	MRPT_END
 }
@@ -63,12 +63,20 @@ class CFileGZInputStream : public CStream
 	/** Method for getting the total number of <b>compressed</b> bytes of in the
 	 * file (the physical size of the compressed file). */
 	uint64_t getTotalBytesCount() const override;
-	/** Method for getting the current cursor position in the <b>compressed</b>,
-	 * where 0 is the first byte and TotalBytesCount-1 the last one. */
+	/** Method for getting the current cursor position in the
+	 * <b>uncompressed</b> data, where 0 is the first byte. */
 	uint64_t getPosition() const override;
 
-	/** This method is not implemented in this class */
-	uint64_t Seek(int64_t, CStream::TSeekOrigin = sFromBeginning) override;
+	/** Moves the read cursor, in <b>uncompressed</b> bytes (the same units
+	 * than getPosition()). Only sFromBeginning and sFromCurrent are supported.
+	 * For uncompressed files this is a plain file seek; for gz-compressed ones,
+	 * seeking forward decompresses and skips data, and seeking backwards
+	 * restarts decompressing from the beginning of the file, so random access
+	 * is only efficient on uncompressed files.
+	 * \return The new position
+	 * \exception std::exception On sFromEnd or errors. */
+	uint64_t Seek(
+		int64_t off, CStream::TSeekOrigin Origin = sFromBeginning) override;
 	size_t Read(void* Buffer, size_t Count) override;
 	size_t Write(const void* Buffer, size_t Count) override;
 };  // End of class def.
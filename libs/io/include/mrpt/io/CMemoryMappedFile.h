@@ -0,0 +1,73 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+namespace mrpt
+{
+namespace io
+{
+/** A read-only view of the whole contents of a file, mapped into memory with
+ * mmap() (or MapViewOfFile() in Windows), so pages are only loaded from disk
+ * as they are accessed.
+ *
+ *  \code
+ *    CMemoryMappedFile f;
+ *    if (f.open("data.bin"))
+ *      process(f.data(), f.size());
+ *  \endcode
+ *
+ * \sa CFileInputStream
+ * \ingroup mrpt_io_grp
+ */
+class CMemoryMappedFile
+{
+   public:
+	/** Default constructor, without opening any file */
+	CMemoryMappedFile() = default;
+	/** Constructor and open
+	 * \exception std::exception If there's an error opening the file.
+	 */
+	CMemoryMappedFile(const std::string& fileName);
+
+	CMemoryMappedFile(const CMemoryMappedFile&) = delete;
+	CMemoryMappedFile& operator=(const CMemoryMappedFile&) = delete;
+
+	virtual ~CMemoryMappedFile();
+
+	/** Maps the given file into memory, closing the previous one (if any).
+	 * \return false on any error opening or mapping the file.
+	 */
+	bool open(const std::string& fileName);
+	/** Unmaps and closes the file */
+	void close();
+	/** Returns true if a file is currently mapped */
+	bool isOpen() const { return m_open; }
+
+	/** Pointer to the first byte of the file (nullptr for empty files) */
+	const uint8_t* data() const { return m_data; }
+	/** The file size, in bytes */
+	size_t size() const { return m_size; }
+
+   private:
+	const uint8_t* m_data{nullptr};
+	size_t m_size{0};
+	bool m_open{false};
+#ifdef _WIN32
+	void* m_hFile{nullptr};
+	void* m_hMapping{nullptr};
+#else
+	int m_fd{-1};
+#endif
+};
+}  // namespace io
+}  // namespace mrpt
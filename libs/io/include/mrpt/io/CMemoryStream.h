@@ -20,6 +20,12 @@ namespace io
  *   and then read them to other objects, or storing them to a file, for
  * example.
  *
+ * It supports zero-copy reads (see ReadInPlace()), which are used by
+ * deserializers of large arrays via
+ * mrpt::serialization::CArchive::ReadBufferFixEndiannessAssign(). Combined
+ * with assignMemoryNotOwn() and a mrpt::io::CMemoryMappedFile, this allows
+ * deserializing files without any intermediary copy.
+ *
  * \sa CStream
  * \ingroup mrpt_io_grp
  */
@@ -28,6 +34,7 @@ class CMemoryStream : public CStream
    public:
 	size_t Read(void* Buffer, size_t Count) override;
 	size_t Write(const void* Buffer, size_t Count) override;
+	const void* ReadInPlace(size_t Count) override;
 
    protected:
 	/** Internal data */
@@ -90,7 +97,9 @@ class CMemoryStream : public CStream
 	bool loadBufferFromFile(const std::string& file_name);
 
 	/** Change the size of the additional memory block that is reserved whenever
-	 * the current block runs too short (default=0x10000 bytes) */
+	 * the current block runs too short (default=0x1000 bytes). The buffer
+	 * grows by at least 50% of its current size, to keep the cost of writing
+	 * long streams linear. */
 	void setAllocBlockSize(uint64_t alloc_block_size)
 	{
 		ASSERT_(alloc_block_size > 0);
@@ -66,6 +66,20 @@ class CStream
 		return Read(Buffer, Count);
 	}
 
+	/** For memory-backed streams, returns a pointer to the next \a Count
+	 * bytes in the stream memory, without copying them, and advances the read
+	 * position. The memory is owned by the stream and it is valid while the
+	 * stream is not modified or destroyed.
+	 * \return nullptr, without reading anything, if the stream does not
+	 * support in-place reads (the default) or there are not enough bytes left.
+	 * \sa mrpt::serialization::CArchive::ReadBufferInPlace
+	 */
+	virtual const void* ReadInPlace(size_t Count)
+	{
+		MRPT_UNUSED_PARAM(Count);
+		return nullptr;
+	}
+
 	/** Introduces a pure virtual method for moving to a specified position in
 	 *the streamed resource.
 	 *   he Origin parameter indicates how to interpret the Offset parameter.
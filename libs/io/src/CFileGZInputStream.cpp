@@ -105,7 +105,25 @@ bool CFileGZInputStream::checkEOF()
 		return 0 != gzeof(THE_GZFILE);
 }
 
-uint64_t CFileGZInputStream::Seek(int64_t, CStream::TSeekOrigin)
+uint64_t CFileGZInputStream::Seek(int64_t off, CStream::TSeekOrigin Origin)
 {
-	THROW_EXCEPTION("Method not available in this class.");
+	if (!m_f)
+	{
+		THROW_EXCEPTION("File is not open.");
+	}
+	int whence;
+	switch (Origin)
+	{
+		case sFromBeginning:
+			whence = SEEK_SET;
+			break;
+		case sFromCurrent:
+			whence = SEEK_CUR;
+			break;
+		default:
+			THROW_EXCEPTION("sFromEnd is not supported by gz streams.");
+	};
+	const auto pos = gzseek(THE_GZFILE, off, whence);
+	if (pos < 0) THROW_EXCEPTION("Error seeking in gz stream.");
+	return static_cast<uint64_t>(pos);
 }
@@ -95,6 +95,14 @@ size_t CMemoryStream::Read(void* Buffer, size_t Count)
 	return nToRead;
 }
 
+const void* CMemoryStream::ReadInPlace(size_t Count)
+{
+	if (m_position + Count > m_size) return nullptr;
+	const void* p = static_cast<const char*>(m_memory.get()) + m_position;
+	m_position += Count;
+	return p;
+}
+
 size_t CMemoryStream::Write(const void* Buffer, size_t Count)
 {
 	// Enought space in current bufer?
@@ -102,8 +110,10 @@ size_t CMemoryStream::Write(const void* Buffer, size_t Count)
 
 	if (requiredSize >= m_size)
 	{
-		// Incrent the size of reserved memory:
-		resize(requiredSize + m_alloc_block_size);
+		// Increment the size of reserved memory, geometrically to avoid
+		// reallocating for each write of long streams:
+		resize(max<uint64_t>(
+			requiredSize + m_alloc_block_size, m_size + m_size / 2));
 	}
 
 	// Copy the memory block:
@@ -12,3 +12,32 @@
 
 MRPT_TODO("implement tests!");
 TEST(CMemoryStream, readwrite) {}
+
+TEST(CMemoryStream, ReadInPlace)
+{
+	mrpt::io::CMemoryStream f;
+	const char msg[] = "0123456789";
+	f.Write(msg, sizeof(msg));
+	f.Seek(2);
+	const auto* p = static_cast<const char*>(f.ReadInPlace(3));
+	ASSERT_TRUE(p != nullptr);
+	EXPECT_EQ(std::string(p, 3), "234");
+	EXPECT_EQ(f.getPosition(), 5u);
+
+	// Read-only memory blocks:
+	mrpt::io::CMemoryStream g;
+	g.assignMemoryNotOwn(msg, sizeof(msg));
+	EXPECT_EQ(g.ReadInPlace(4), static_cast<const void*>(msg));
+	EXPECT_TRUE(g.ReadInPlace(sizeof(msg)) == nullptr);
+	EXPECT_EQ(g.getPosition(), 4u);
+}
+
+TEST(CMemoryStream, writeManySmallBlocks)
+{
+	mrpt::io::CMemoryStream f;
+	f.setAllocBlockSize(16);
+	for (uint32_t i = 0; i < 100000; i++) f.Write(&i, sizeof(i));
+	ASSERT_EQ(f.getTotalBytesCount(), 100000 * sizeof(uint32_t));
+	const auto* d = static_cast<const uint32_t*>(f.getRawBufferData());
+	for (uint32_t i = 0; i < 100000; i += 997) EXPECT_EQ(d[i], i);
+}
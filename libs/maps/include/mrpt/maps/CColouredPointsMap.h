@@ -165,7 +165,7 @@ class CColouredPointsMap : public CPointsMap
 	inline void insertPoint(float x, float y, float z)
 	{
 		insertPointFast(x, y, z);
-		mark_as_modified();
+		mark_as_appended();
 	}
 
 	/** Changes just the color of a given point from the map. First index is 0.
@@ -87,8 +87,9 @@ class COccupancyGridMap2D : public CMetricMap,
 	static const cellType OCCGRID_P2LTABLE_SIZE =
 		CLogOddsGridMap2D<cellType>::P2LTABLE_SIZE;
 
-	/** (Default:1.0) Can be set to <1 if a more fine raytracing is needed in
-	 * sonarSimulator() and laserScanSimulator(), or >1 to speed it up. */
+	/** Not used anymore: rays are now traced exactly, visiting each cell
+	 * once, in sonarSimulator() and laserScanSimulator().
+	 * \deprecated Kept for backwards compatibility, has no effect. */
 	static double RAYTRACE_STEP_SIZE_IN_CELL_UNITS;
 
    protected:
@@ -114,6 +115,49 @@ class COccupancyGridMap2D : public CMetricMap,
 	 * (see TLikelihoodOptions::enableLikelihoodCache). */
 	std::vector<double> precomputedLikelihood;
 	bool precomputedLikelihoodToBeRecomputed;
+	/** Whether all the entries of precomputedLikelihood are valid, see
+	 * precomputeLikelihoodFieldCache(). Only meaningful while
+	 * precomputedLikelihoodToBeRecomputed is false. */
+	bool precomputedLikelihoodIsComplete;
+	/** The logarithm of precomputedLikelihood, in single precision, plus one
+	 * extra trailing entry for cells out of the grid. Filled in by
+	 * precomputeLikelihoodFieldCache() and used by the batch version of
+	 * computeLikelihoodField_Thrun(). */
+	std::vector<float> precomputedLogLikelihood;
+	/** Static map mode: squared Euclidean distance, in cells^2 and saturated
+	 * at 65535, from each cell to the closest occupied cell, plus one trailing
+	 * entry (0xFFFF) for cells out of the grid. Empty unless
+	 * precomputeDistanceTransform() was called and the map was not modified
+	 * afterwards. \sa isDistanceTransformValid() */
+	std::vector<uint16_t> m_likelihoodDistanceTransform;
+	/** Likelihood-field values for each squared distance stored in
+	 * m_likelihoodDistanceTransform, for the likelihood options and
+	 * resolution they were computed for. See updateDistanceTransformLUT() */
+	struct TDistanceTransformLUT
+	{
+		float resolution{0}, LF_stdHit{0}, LF_zHit{0}, LF_zRandom{0},
+			LF_maxRange{0}, LF_maxCorrsDistance{0};
+		bool LF_useSquareDist{false};
+		/** Likelihood (and its log) for squared distances 0,1,...,N-2 (in
+		 * cells^2, any larger distance uses entry N-2), and for points out
+		 * of the grid (entry N-1). */
+		std::vector<double> lik, logLik;
+	};
+	TDistanceTransformLUT m_distanceTransformLUT;
+	/** Precomputed simulated ranges for each cell and discretized direction,
+	 * see precomputeRayCastLUT() */
+	struct TRayCastLUT
+	{
+		unsigned int nAngles{0};
+		float maxRange{0};
+		/** The free-cell threshold, in log-odds, used to build the table */
+		cellType thresholdFree{0};
+		/** Ranges, in units of maxRange/65534, for the nAngles directions of
+		 * cell 0, then those of cell 1, etc. 0xFFFF means an invalid range
+		 * (nothing hit within maxRange, or an unknown cell was hit). */
+		std::vector<uint16_t> ranges;
+	};
+	TRayCastLUT m_rayCastLUT;
 
 	/** Used for Voronoi calculation.Same struct as "map", but contains a "0" if
 	 * not a basis point. */
@@ -193,6 +237,34 @@ class COccupancyGridMap2D : public CMetricMap,
 	double computeObservationLikelihood_likelihoodField_II(
 		const mrpt::obs::CObservation* obs,
 		const mrpt::poses::CPose2D& takenFrom);
+	/** Likelihood of a single point falling into cell (cx,cy), for the
+	 * lmLikelihoodField_Thrun method. K is the search window half-size, in
+	 * cells. */
+	double computeLikelihoodField_Thrun_cell(
+		const int cx, const int cy, const int K) const;
+	/** If the map was modified since the likelihood caches were built
+	 * (precomputedLikelihoodToBeRecomputed), drops all of them, including
+	 * the distance transform of the static map mode and the ray casting LUT.
+	 */
+	void resetLikelihoodCachesIfOutdated();
+	/** Rebuilds m_distanceTransformLUT if the likelihood options changed */
+	void updateDistanceTransformLUT();
+	/** Exact grid traversal (Amanatides & Woo) of one ray with unit direction
+	 * (cosA,sinA), until it enters a cell not above `thresholdFree` (in
+	 * log-odds), leaves the grid or goes beyond `maxRange`. The range is the
+	 * distance to the border of the hit cell. */
+	void rayTraceDDA(
+		const double x, const double y, const double cosA, const double sinA,
+		const double maxRange, const cellType thresholdFree, float& out_range,
+		bool& out_valid) const;
+	/** Whether m_rayCastLUT can replace rayTraceDDA() for these parameters */
+	bool canUseRayCastLUT(
+		const cellType thresholdFree, const double maxRange) const;
+	/** Looks up the range of the ray from (x,y) with direction `angle` in
+	 * m_rayCastLUT. Check canUseRayCastLUT() first. */
+	void rayCastLUTLookup(
+		const double x, const double y, const double angle,
+		const double maxRange, float& out_range, bool& out_valid) const;
 
 	/** Clear the map: It set all cells to their default occupancy value (0.5),
 	 * without changing the resolution (the grid extension is reset to the
@@ -800,7 +872,7 @@ class COccupancyGridMap2D : public CMetricMap,
 	 *to the angles at which ranges are measured (in radians).
 	 *
 	 * \sa laserScanSimulatorWithUncertainty(), sonarSimulator(),
-	 *COccupancyGridMap2D::RAYTRACE_STEP_SIZE_IN_CELL_UNITS
+	 *laserScanSimulatorBatch(), precomputeRayCastLUT()
 	 */
 	void laserScanSimulator(
 		mrpt::obs::CObservation2DRangeScan& inout_Scan,
@@ -826,8 +898,7 @@ class COccupancyGridMap2D : public CMetricMap,
 	 * \param angleNoiseStd [IN] The sigma of an optional Gaussian noise added
 	 * to the angles at which ranges are measured (in radians).
 	 *
-	 * \sa laserScanSimulator(),
-	 * COccupancyGridMap2D::RAYTRACE_STEP_SIZE_IN_CELL_UNITS
+	 * \sa laserScanSimulator(), simulateScanRay()
 	 */
 	void sonarSimulator(
 		mrpt::obs::CObservationRange& inout_observation,
@@ -836,14 +907,75 @@ class COccupancyGridMap2D : public CMetricMap,
 		float angleNoiseStd = mrpt::DEG2RAD(0.f)) const;
 
 	/** Simulate just one "ray" in the grid map. This method is used internally
-	 * to sonarSimulator and laserScanSimulator. \sa
-	 * COccupancyGridMap2D::RAYTRACE_STEP_SIZE_IN_CELL_UNITS */
+	 * to sonarSimulator and laserScanSimulator.
+	 * The ray is traced with the exact grid traversal algorithm of Amanatides
+	 * & Woo (a DDA visiting each crossed cell once), and the returned range
+	 * is the distance to the border of the first cell whose free probability
+	 * is not above `threshold_free`. If precomputeRayCastLUT() was called
+	 * with the same threshold and a `maxRange` not below `max_range_meters`,
+	 * the range is read from that table instead. */
 	void simulateScanRay(
 		const double x, const double y, const double angle_direction,
 		float& out_range, bool& out_valid, const double max_range_meters,
 		const float threshold_free = 0.4f, const double noiseStd = .0,
 		const double angleNoiseStd = .0) const;
 
+	/** Batch version of laserScanSimulator() for many robot poses at once,
+	 * e.g. one per particle in beam-model Monte Carlo localization. Rays are
+	 * traced as in simulateScanRay(), without noise, split among a pool of
+	 * worker threads.
+	 * \param scanParams Provides the `aperture`, `rightToLeft`, `maxRange`
+	 * and `sensorPose` of the simulated scans. Its ranges are not used.
+	 * \param robotPoses The robot poses, in this map coordinates.
+	 * \param out_ranges On return, `nOut=(N+decimation-1)/decimation`
+	 * consecutive ranges per robot pose, for the rays with indices 0, D, 2D,
+	 * ... of a scan with N rays. The vector is only reallocated if its size
+	 * changes, so the same buffers can be passed in every call.
+	 * \param out_valid Same layout than `out_ranges`, with 1 for valid ranges
+	 * and 0 otherwise.
+	 * \param threshold, N, decimation As in laserScanSimulator().
+	 * The results are identical to those of laserScanSimulator() for the
+	 * same arguments and no noise.
+	 * \note [New in MRPT 2.0.0] */
+	void laserScanSimulatorBatch(
+		const mrpt::obs::CObservation2DRangeScan& scanParams,
+		const std::vector<mrpt::math::TPose2D>& robotPoses,
+		std::vector<float>& out_ranges, std::vector<char>& out_valid,
+		float threshold = 0.6f, size_t N = 361,
+		unsigned int decimation = 1) const;
+
+	/** Precomputes the range of a simulated ray from the center of each cell
+	 * in each of `nAngles` equally-spaced directions, so that later
+	 * simulateScanRay() calls (and hence laserScanSimulator(),
+	 * laserScanSimulatorBatch() and the lmRayTracing likelihood) become a
+	 * single table lookup. Ray origins are rounded to the cell center and
+	 * directions to the closest of the `nAngles` ones, so ranges are
+	 * approximate. The table takes `2*nAngles` bytes per cell: use it for
+	 * static maps only. Inserting observations, resizing or loading the map
+	 * discards it; call this again after editing cells with setCell().
+	 * \param threshold The occupancy threshold, as in laserScanSimulator().
+	 * The table is only used by calls with this same threshold.
+	 * \param maxRange Longest range in the table. The table is only used by
+	 * calls whose maximum range is not larger than this.
+	 * \sa isRayCastLUTValid, clearRayCastLUT
+	 * \note [New in MRPT 2.0.0] */
+	void precomputeRayCastLUT(
+		unsigned int nAngles = 360, float maxRange = 20.0f,
+		float threshold = 0.6f);
+
+	/** Whether the table from precomputeRayCastLUT() is available
+	 * \note [New in MRPT 2.0.0] */
+	inline bool isRayCastLUTValid() const
+	{
+		return !precomputedLikelihoodToBeRecomputed &&
+			   m_rayCastLUT.nAngles > 0 &&
+			   m_rayCastLUT.ranges.size() == map.size() * m_rayCastLUT.nAngles;
+	}
+
+	/** Frees the table from precomputeRayCastLUT(), so exact ray tracing is
+	 * used again \note [New in MRPT 2.0.0] */
+	void clearRayCastLUT();
+
 	/** Methods for TLaserSimulUncertaintyParams in
 	 * laserScanSimulatorWithUncertainty() */
 	enum TLaserSimulUncertaintyMethod
@@ -926,8 +1058,7 @@ class COccupancyGridMap2D : public CMetricMap,
 	 * \param in_params [IN] Input settings. See TLaserSimulUncertaintyParams
 	 * \param in_params [OUT] Output range + uncertainty.
 	 *
-	 * \sa laserScanSimulator(),
-	 * COccupancyGridMap2D::RAYTRACE_STEP_SIZE_IN_CELL_UNITS
+	 * \sa laserScanSimulator(), simulateScanRay()
 	 */
 	void laserScanSimulatorWithUncertainty(
 		const TLaserSimulUncertaintyParams& in_params,
@@ -946,6 +1077,87 @@ class COccupancyGridMap2D : public CMetricMap,
 		const CPointsMap* pm,
 		const mrpt::poses::CPose2D* relativePose = nullptr);
 
+	/** Batch version of computeLikelihoodField_Thrun(), which evaluates the
+	 * same points map `pm` seen from each of the poses in `relativePoses`,
+	 * e.g. one pose per particle in Monte Carlo localization. The output
+	 * log-likelihoods are stored in `out_logLiks`, with one entry per pose.
+	 *
+	 * If TLikelihoodOptions::enableLikelihoodCache is set and
+	 * TLikelihoodOptions::LF_alternateAverageMethod is not, the whole cache is
+	 * filled in first (see precomputeLikelihoodFieldCache()) and the points
+	 * are transformed and looked up four at a time with SSE2, using a single
+	 * precision table of log-likelihoods. Results then match those of
+	 * computeLikelihoodField_Thrun() up to float rounding. Otherwise, this
+	 * just calls computeLikelihoodField_Thrun() once per pose.
+	 * \sa computeObservationLikelihoodBatch
+	 * \note [New in MRPT 2.0.0] */
+	void computeLikelihoodField_Thrun(
+		const CPointsMap* pm,
+		const std::vector<mrpt::math::TPose2D>& relativePoses,
+		std::vector<double>& out_logLiks);
+
+	/** Evaluates computeObservationLikelihood() for one observation and a set
+	 * of robot poses in one call. Only implemented for
+	 * mrpt::obs::CObservation2DRangeScan observations and the
+	 * lmLikelihoodField_Thrun method, for which it uses the batch version of
+	 * computeLikelihoodField_Thrun(), and the lmRayTracing method, which
+	 * simulates all the scans with laserScanSimulatorBatch().
+	 * \return false (and leaves `out_logLiks` untouched) if this observation
+	 * type or likelihood method is not supported, in which case
+	 * computeObservationLikelihood() must be called for each pose instead.
+	 * \note [New in MRPT 2.0.0] */
+	bool computeObservationLikelihoodBatch(
+		const mrpt::obs::CObservation* obs,
+		const std::vector<mrpt::math::TPose2D>& takenFrom,
+		std::vector<double>& out_logLiks);
+
+	/** Fills in all the missing entries of the likelihood-field cache used by
+	 * the lmLikelihoodField_Thrun method (only if
+	 * TLikelihoodOptions::enableLikelihoodCache is set), using one thread per
+	 * core. Afterwards, and until the map is modified,
+	 * computeObservationLikelihood() only reads from the cache, so it can be
+	 * safely called from several threads at once. Calling it again for an
+	 * unmodified map is a no-op.
+	 * In static map mode (see precomputeDistanceTransform()), that cache is
+	 * not needed and this method only updates the distance-to-likelihood
+	 * tables for the current likelihoodOptions.
+	 * \note [New in MRPT 2.0.0] */
+	void precomputeLikelihoodFieldCache();
+
+	/** Enters the "static map mode" for the lmLikelihoodField_Thrun method:
+	 * computes the exact Euclidean distance transform of the map (the
+	 * distance from each cell to the closest occupied one) with the
+	 * linear-time algorithm of Felzenszwalb & Huttenlocher, by columns and
+	 * then by rows, in parallel. It is stored as squared distances in
+	 * cells^2, in 16 bits per cell. Afterwards, the likelihood of each point
+	 * is found with two table lookups and no window search, with the same
+	 * results as computeLikelihoodField_Thrun_cell() for distances below 256
+	 * cells. The distance transform is saved along with the map when
+	 * serialized. Inserting observations, resizing or loading the map
+	 * discards it, returning to the regular mode (see
+	 * TLikelihoodOptions::enableLikelihoodCache); call this again after
+	 * editing cells with setCell().
+	 * \sa isDistanceTransformValid
+	 * \note [New in MRPT 2.0.0] */
+	void precomputeDistanceTransform();
+
+	/** Whether the map is in static map mode, see
+	 * precomputeDistanceTransform() \note [New in MRPT 2.0.0] */
+	inline bool isDistanceTransformValid() const
+	{
+		return !precomputedLikelihoodToBeRecomputed &&
+			   m_likelihoodDistanceTransform.size() == map.size() + 1;
+	}
+
+	/** Squared distance, in cells^2 (saturated at 65535), from cell (cx,cy)
+	 * to the closest occupied cell. Only valid while
+	 * isDistanceTransformValid() \note [New in MRPT 2.0.0] */
+	inline uint16_t getDistanceTransformSqr(int cx, int cy) const
+	{
+		ASSERT_(isDistanceTransformValid());
+		return m_likelihoodDistanceTransform[cx + cy * size_x];
+	}
+
 	/** Computes the likelihood [0,1] of a set of points, given the current grid
 	 * map as reference.
 	 * \param pm The points map
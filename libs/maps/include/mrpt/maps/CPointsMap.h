@@ -580,7 +580,7 @@ class CPointsMap : public CMetricMap,
 	inline void insertPoint(float x, float y, float z = 0)
 	{
 		insertPointFast(x, y, z);
-		mark_as_modified();
+		mark_as_appended();
 	}
 	/// \overload
 	inline void insertPoint(const mrpt::math::TPoint3D& p)
@@ -1070,6 +1070,17 @@ class CPointsMap : public CMetricMap,
 		kdtree_mark_as_outdated();
 	}
 
+	/** Like mark_as_modified(), for changes that only append new points at the
+	 * end of the cloud, leaving existing points untouched. With an incremental
+	 * KD-tree (see kdtree_search_params) only the new points will be indexed.
+	 */
+	inline void mark_as_appended() const
+	{
+		m_largestDistanceFromOriginIsUpdated = false;
+		m_boundingBoxIsUpdated = false;
+		kdtree_mark_as_appended();
+	}
+
    protected:
 	/** The point coordinates */
 	std::vector<float> x, y, z;
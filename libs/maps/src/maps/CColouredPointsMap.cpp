@@ -92,6 +92,7 @@ void CColouredPointsMap::reserve(size_t newLength)
 //  and old contents are not changed.
 void CColouredPointsMap::resize(size_t newLength)
 {
+	const bool growing = newLength >= x.size();
 	this->reserve(newLength);  // to ensure 4N capacity
 
 	x.resize(newLength, 0);
@@ -100,7 +101,10 @@ void CColouredPointsMap::resize(size_t newLength)
 	m_color_R.resize(newLength, 1);
 	m_color_G.resize(newLength, 1);
 	m_color_B.resize(newLength, 1);
-	mark_as_modified();
+	if (growing)
+		mark_as_appended();
+	else
+		mark_as_modified();
 }
 
 // Resizes all point buffers so they can hold the given number of points,
@@ -174,14 +178,12 @@ void CColouredPointsMap::serializeFrom(
 			uint32_t n;
 			in >> n;
 
+			// Bulk reads straight into the coordinates (a single copy from
+			// memory streams), then resize all other per-point fields:
+			in.ReadBufferFixEndiannessAssign(x, n);
+			in.ReadBufferFixEndiannessAssign(y, n);
+			in.ReadBufferFixEndiannessAssign(z, n);
 			this->resize(n);
-
-			if (n > 0)
-			{
-				in.ReadBufferFixEndianness(&x[0], n);
-				in.ReadBufferFixEndianness(&y[0], n);
-				in.ReadBufferFixEndianness(&z[0], n);
-			}
 			in >> m_color_R >> m_color_G >> m_color_B;
 
 			if (version >= 9)
@@ -380,7 +382,7 @@ void CColouredPointsMap::insertPoint(
 	m_color_G.push_back(G);
 	m_color_B.push_back(B);
 
-	mark_as_modified();
+	mark_as_appended();
 }
 
 /*---------------------------------------------------------------
@@ -115,6 +115,7 @@ COccupancyGridMap2D::COccupancyGridMap2D(
 	  resolution(),
 	  precomputedLikelihood(),
 	  precomputedLikelihoodToBeRecomputed(true),
+	  precomputedLikelihoodIsComplete(false),
 	  m_basis_map(),
 	  m_voronoi_diagram(),
 	  m_is_empty(true),
@@ -14,6 +14,11 @@
 #include <mrpt/obs/CObservationRange.h>
 #include <mrpt/maps/CSimplePointsMap.h>
 #include <mrpt/serialization/CArchive.h>
+#include <mrpt/system/CWorkerThreadsPool.h>
+
+#if MRPT_HAS_SSE2
+#include <mrpt/core/SSE_types.h>
+#endif
 
 using namespace mrpt;
 using namespace mrpt::math;
@@ -522,6 +527,8 @@ double COccupancyGridMap2D::computeObservationLikelihood_likelihoodField_II(
 /*---------------------------------------------------------------
 					computeLikelihoodField_Thrun
  ---------------------------------------------------------------*/
+#define LIK_LF_CACHE_INVALID (66)
+
 double COccupancyGridMap2D::computeLikelihoodField_Thrun(
 	const CPointsMap* pm, const CPose2D* relativePose)
 {
@@ -554,56 +561,79 @@ double COccupancyGridMap2D::computeLikelihoodField_Thrun(
 	unsigned int size_x_1 = size_x - 1;
 	unsigned int size_y_1 = size_y - 1;
 
-#define LIK_LF_CACHE_INVALID (66)
-
 	// Aux. variables for the "for j" loop:
 	double thisLik = LIK_LF_CACHE_INVALID;
 	double maxCorrDist_sq = square(likelihoodOptions.LF_maxCorrsDistance);
 	double minimumLik = zRandomTerm + zHit * exp(Q * maxCorrDist_sq);
 	double ccos, ssin;
-	float occupiedMinDist;
 
-	if (likelihoodOptions.enableLikelihoodCache)
-	{
-		// Reset the precomputed likelihood values map
-		if (precomputedLikelihoodToBeRecomputed)
-		{
-			if (!map.empty())
-				precomputedLikelihood.assign(map.size(), LIK_LF_CACHE_INVALID);
-			else
-				precomputedLikelihood.clear();
-
-			precomputedLikelihoodToBeRecomputed = false;
-		}
-	}
+	// Reset the precomputed likelihood values map, if the map changed:
+	resetLikelihoodCachesIfOutdated();
 
-	cellType thresholdCellValue = p2l(0.5f);
 	int decimation = likelihoodOptions.LF_decimation;
 
-	const double _resolution = this->resolution;
-	const double constDist2DiscrUnits = 100 / (_resolution * _resolution);
-	const double constDist2DiscrUnits_INV = 1.0 / constDist2DiscrUnits;
-
 	if (N < 10) decimation = 1;
 
 	TPoint2D pointLocal;
 	TPoint2D pointGlobal;
 
-	for (size_t j = 0; j < N; j += decimation)
+	if (relativePose)
 	{
-		occupiedMinDist = maxCorrDist_sq;  // The max.distance
+#ifdef HAVE_SINCOS
+		::sincos(relativePose->phi(), &ssin, &ccos);
+#else
+		ccos = cos(relativePose->phi());
+		ssin = sin(relativePose->phi());
+#endif
+	}
+	else
+	{
+		ccos = 1;
+		ssin = 0;
+	}
+	const double x0 = relativePose ? relativePose->x() : 0;
+	const double y0 = relativePose ? relativePose->y() : 0;
 
+	if (isDistanceTransformValid())
+	{
+		// Static map mode: just two table lookups per point.
+		updateDistanceTransformLUT();
+		const auto& lut = m_distanceTransformLUT;
+		const double* lik = Product_T_OrSum_F ? &lut.logLik[0] : &lut.lik[0];
+		const size_t lutOutOfGrid = lut.lik.size() - 1;
+		const uint16_t lutMaxDist = static_cast<uint16_t>(lutOutOfGrid - 1);
+		const uint16_t* dist = &m_likelihoodDistanceTransform[0];
+		const size_t outOfGrid = map.size();
+
+		for (size_t j = 0; j < N; j += decimation)
+		{
+			pm->getPoint(j, pointLocal);
+			const int cx = x2idx(x0 + pointLocal.x * ccos - pointLocal.y * ssin);
+			const int cy = y2idx(y0 + pointLocal.x * ssin + pointLocal.y * ccos);
+			const bool in = static_cast<unsigned>(cx) < size_x_1 &&
+							static_cast<unsigned>(cy) < size_y_1;
+			const uint16_t d = dist[in ? cx + cy * size_x : outOfGrid];
+			ret += lik[in ? std::min(d, lutMaxDist) : lutOutOfGrid];
+			M++;
+		}
+		if (!Product_T_OrSum_F) ret = log(ret / M);
+		return ret;
+	}
+
+	if (likelihoodOptions.enableLikelihoodCache &&
+		precomputedLikelihood.size() != map.size())
+	{
+		precomputedLikelihood.assign(map.size(), LIK_LF_CACHE_INVALID);
+		precomputedLikelihoodIsComplete = false;
+	}
+
+	for (size_t j = 0; j < N; j += decimation)
+	{
 		// Get the point and pass it to global coordinates:
 		if (relativePose)
 		{
 			pm->getPoint(j, pointLocal);
-// pointGlobal = *relativePose + pointLocal;
-#ifdef HAVE_SINCOS
-			::sincos(relativePose->phi(), &ssin, &ccos);
-#else
-			ccos = cos(relativePose->phi());
-			ssin = sin(relativePose->phi());
-#endif
+			// pointGlobal = *relativePose + pointLocal;
 			pointGlobal.x =
 				relativePose->x() + pointLocal.x * ccos - pointLocal.y * ssin;
 			pointGlobal.y =
@@ -639,57 +669,7 @@ double COccupancyGridMap2D::computeLikelihoodField_Thrun(
 				thisLik == LIK_LF_CACHE_INVALID)
 			{
 				// Compute now:
-				// -------------
-				// Find the closest occupied cell in a certain range, given by
-				// K:
-				int xx1 = max(0, cx - K);
-				int xx2 = min(size_x_1, (unsigned)(cx + K));
-				int yy1 = max(0, cy - K);
-				int yy2 = min(size_y_1, (unsigned)(cy + K));
-
-				// Optimized code: this part will be invoked a *lot* of times:
-				{
-					cellType* mapPtr =
-						&map[xx1 + yy1 * size_x];  // Initial pointer position
-					unsigned incrAfterRow = size_x - ((xx2 - xx1) + 1);
-
-					signed int Ax0 = 10 * (xx1 - cx);
-					signed int Ay = 10 * (yy1 - cy);
-
-					unsigned int occupiedMinDistInt =
-						mrpt::round(maxCorrDist_sq * constDist2DiscrUnits);
-
-					for (int yy = yy1; yy <= yy2; yy++)
-					{
-						unsigned int Ay2 =
-							square((unsigned int)(Ay));  // Square is faster
-						// with unsigned.
-						signed short Ax = Ax0;
-						cellType cell;
-
-						for (int xx = xx1; xx <= xx2; xx++)
-						{
-							if ((cell = *mapPtr++) < thresholdCellValue)
-							{
-								unsigned int d =
-									square((unsigned int)(Ax)) + Ay2;
-								keep_min(occupiedMinDistInt, d);
-							}
-							Ax += 10;
-						}
-						// Go to (xx1,yy++)
-						mapPtr += incrAfterRow;
-						Ay += 10;
-					}
-
-					occupiedMinDist =
-						occupiedMinDistInt * constDist2DiscrUnits_INV;
-				}
-
-				if (likelihoodOptions.LF_useSquareDist)
-					occupiedMinDist *= occupiedMinDist;
-
-				thisLik = zRandomTerm + zHit * exp(Q * occupiedMinDist);
+				thisLik = computeLikelihoodField_Thrun_cell(cx, cy, K);
 
 				if (likelihoodOptions.enableLikelihoodCache)
 					// And save it into the table and into "thisLik":
@@ -716,6 +696,540 @@ double COccupancyGridMap2D::computeLikelihoodField_Thrun(
 	MRPT_END
 }
 
+double COccupancyGridMap2D::computeLikelihoodField_Thrun_cell(
+	const int cx, const int cy, const int K) const
+{
+	const float zHit = likelihoodOptions.LF_zHit;
+	const float zRandomTerm =
+		likelihoodOptions.LF_zRandom / likelihoodOptions.LF_maxRange;
+	const float Q = -0.5f / square(likelihoodOptions.LF_stdHit);
+	const double maxCorrDist_sq =
+		square(likelihoodOptions.LF_maxCorrsDistance);
+
+	const unsigned int size_x_1 = size_x - 1;
+	const unsigned int size_y_1 = size_y - 1;
+	const cellType thresholdCellValue = p2l(0.5f);
+
+	const double _resolution = this->resolution;
+	const double constDist2DiscrUnits = 100 / (_resolution * _resolution);
+	const double constDist2DiscrUnits_INV = 1.0 / constDist2DiscrUnits;
+
+	// Find the closest occupied cell in a certain range, given by K:
+	int xx1 = max(0, cx - K);
+	int xx2 = min(size_x_1, (unsigned)(cx + K));
+	int yy1 = max(0, cy - K);
+	int yy2 = min(size_y_1, (unsigned)(cy + K));
+
+	float occupiedMinDist;
+
+	// Optimized code: this part will be invoked a *lot* of times:
+	{
+		const cellType* mapPtr =
+			&map[xx1 + yy1 * size_x];  // Initial pointer position
+		unsigned incrAfterRow = size_x - ((xx2 - xx1) + 1);
+
+		signed int Ax0 = 10 * (xx1 - cx);
+		signed int Ay = 10 * (yy1 - cy);
+
+		unsigned int occupiedMinDistInt =
+			mrpt::round(maxCorrDist_sq * constDist2DiscrUnits);
+
+		for (int yy = yy1; yy <= yy2; yy++)
+		{
+			unsigned int Ay2 = square((unsigned int)(Ay));  // Square is faster
+			// with unsigned.
+			signed short Ax = Ax0;
+			cellType cell;
+
+			for (int xx = xx1; xx <= xx2; xx++)
+			{
+				if ((cell = *mapPtr++) < thresholdCellValue)
+				{
+					unsigned int d = square((unsigned int)(Ax)) + Ay2;
+					keep_min(occupiedMinDistInt, d);
+				}
+				Ax += 10;
+			}
+			// Go to (xx1,yy++)
+			mapPtr += incrAfterRow;
+			Ay += 10;
+		}
+
+		occupiedMinDist = occupiedMinDistInt * constDist2DiscrUnits_INV;
+	}
+
+	if (likelihoodOptions.LF_useSquareDist)
+		occupiedMinDist *= occupiedMinDist;
+
+	return zRandomTerm + zHit * exp(Q * occupiedMinDist);
+}
+
+/*---------------------------------------------------------------
+				resetLikelihoodCachesIfOutdated
+ ---------------------------------------------------------------*/
+void COccupancyGridMap2D::resetLikelihoodCachesIfOutdated()
+{
+	if (!precomputedLikelihoodToBeRecomputed) return;
+	precomputedLikelihood.clear();
+	precomputedLogLikelihood.clear();
+	precomputedLikelihoodIsComplete = false;
+	m_likelihoodDistanceTransform.clear();
+	m_rayCastLUT.ranges.clear();
+	precomputedLikelihoodToBeRecomputed = false;
+}
+
+/*---------------------------------------------------------------
+				precomputeLikelihoodFieldCache
+ ---------------------------------------------------------------*/
+void COccupancyGridMap2D::precomputeLikelihoodFieldCache()
+{
+	MRPT_START
+	resetLikelihoodCachesIfOutdated();
+	if (isDistanceTransformValid())
+	{
+		// Static map mode: no per-cell cache needed.
+		updateDistanceTransformLUT();
+		return;
+	}
+	if (!likelihoodOptions.enableLikelihoodCache) return;
+	if (precomputedLikelihoodIsComplete &&
+		precomputedLikelihood.size() == map.size() &&
+		precomputedLogLikelihood.size() == map.size() + 1)
+		return;  // Nothing to do
+
+	if (precomputedLikelihood.size() != map.size())
+		precomputedLikelihood.assign(map.size(), LIK_LF_CACHE_INVALID);
+
+	// The likelihood assigned to points out of the grid (see
+	// computeLikelihoodField_Thrun()):
+	const float zRandomTerm =
+		likelihoodOptions.LF_zRandom / likelihoodOptions.LF_maxRange;
+	const float Q = -0.5f / square(likelihoodOptions.LF_stdHit);
+	const double maxCorrDist_sq =
+		square(likelihoodOptions.LF_maxCorrsDistance);
+	const float logMinimumLik = static_cast<float>(log(
+		zRandomTerm + likelihoodOptions.LF_zHit * exp(Q * maxCorrDist_sq)));
+	precomputedLogLikelihood.assign(map.size() + 1, logMinimumLik);
+
+	if (size_x >= 2 && size_y >= 2)
+	{
+		const int K =
+			(int)ceil(likelihoodOptions.LF_maxCorrsDistance / resolution);
+
+		// Cells in the last row and column are never looked up in the
+		// cache. Each task fills a block of rows:
+		const unsigned int nRows = size_y - 1, ROWS_PER_TASK = 16;
+		mrpt::system::CWorkerThreadsPool pool;
+		std::vector<std::future<void>> futs;
+		for (unsigned int cy0 = 0; cy0 < nRows; cy0 += ROWS_PER_TASK)
+		{
+			const unsigned int cy1 = std::min(nRows, cy0 + ROWS_PER_TASK);
+			futs.emplace_back(pool.enqueue([this, K, cy0, cy1]() {
+				for (unsigned int cy = cy0; cy < cy1; cy++)
+				{
+					double* lik = &precomputedLikelihood[cy * size_x];
+					float* logLik = &precomputedLogLikelihood[cy * size_x];
+					for (unsigned int cx = 0; cx < size_x - 1; cx++)
+					{
+						if (lik[cx] == LIK_LF_CACHE_INVALID)
+							lik[cx] =
+								computeLikelihoodField_Thrun_cell(cx, cy, K);
+						logLik[cx] = static_cast<float>(log(lik[cx]));
+					}
+				}
+			}));
+		}
+		for (auto& f : futs) f.wait();
+		for (auto& f : futs) f.get();
+	}
+	precomputedLikelihoodIsComplete = true;
+	MRPT_END
+}
+
+/*---------------------------------------------------------------
+				precomputeDistanceTransform
+ ---------------------------------------------------------------*/
+void COccupancyGridMap2D::precomputeDistanceTransform()
+{
+	MRPT_START
+
+	resetLikelihoodCachesIfOutdated();
+	// Not needed in static map mode:
+	precomputedLikelihood.clear();
+	precomputedLogLikelihood.clear();
+	precomputedLikelihoodIsComplete = false;
+
+	const int W = static_cast<int>(size_x), H = static_cast<int>(size_y);
+	const cellType thresholdCellValue = p2l(0.5f);
+	// Larger than any distance within the grid, and with a square that
+	// saturates the uint16 output for rows/columns without obstacles:
+	const int INF = W + H + 256;
+
+	// 1st pass: vertical distance, in cells, from each cell to the closest
+	// occupied cell in its column. Each task processes a block of columns:
+	std::vector<int> g(map.size());
+	const int COLS_PER_TASK = 64, ROWS_PER_TASK = 16;
+	mrpt::system::CWorkerThreadsPool pool;
+	std::vector<std::future<void>> futs;
+	for (int cx0 = 0; cx0 < W; cx0 += COLS_PER_TASK)
+	{
+		const int cx1 = std::min(W, cx0 + COLS_PER_TASK);
+		futs.emplace_back(
+			pool.enqueue([this, &g, W, H, INF, thresholdCellValue, cx0, cx1]() {
+				for (int cx = cx0; cx < cx1; cx++)
+					g[cx] = map[cx] < thresholdCellValue ? 0 : INF;
+				for (int cy = 1; cy < H; cy++)
+					for (int cx = cx0; cx < cx1; cx++)
+					{
+						const int i = cx + cy * W;
+						g[i] = map[i] < thresholdCellValue
+								   ? 0
+								   : std::min(INF, g[i - W] + 1);
+					}
+				for (int cy = H - 2; cy >= 0; cy--)
+					for (int cx = cx0; cx < cx1; cx++)
+					{
+						const int i = cx + cy * W;
+						g[i] = std::min(g[i], g[i + W] + 1);
+					}
+			}));
+	}
+	for (auto& f : futs) f.wait();
+	for (auto& f : futs) f.get();
+	futs.clear();
+
+	// 2nd pass: for each row, squared distance as the lower envelope of the
+	// parabolas (cx-q)^2+g(q)^2 (Felzenszwalb & Huttenlocher, 2012):
+	m_likelihoodDistanceTransform.resize(map.size() + 1);
+	m_likelihoodDistanceTransform.back() = 0xFFFF;  // Out of the grid
+	for (int cy0 = 0; cy0 < H; cy0 += ROWS_PER_TASK)
+	{
+		const int cy1 = std::min(H, cy0 + ROWS_PER_TASK);
+		futs.emplace_back(pool.enqueue([this, &g, W, cy0, cy1]() {
+			std::vector<double> f(W), z(W + 1);
+			std::vector<int> v(W);
+			for (int cy = cy0; cy < cy1; cy++)
+			{
+				const int* gRow = &g[cy * W];
+				for (int q = 0; q < W; q++) f[q] = square(double(gRow[q]));
+
+				// Lower envelope:
+				int k = 0;
+				v[0] = 0;
+				z[0] = -std::numeric_limits<double>::max();
+				z[1] = std::numeric_limits<double>::max();
+				for (int q = 1; q < W; q++)
+				{
+					double s;
+					for (;;)
+					{
+						const int p = v[k];
+						s = ((f[q] + q * q) - (f[p] + p * p)) / (2 * (q - p));
+						if (s > z[k] || k == 0) break;
+						k--;
+					}
+					k++;
+					v[k] = q;
+					z[k] = s;
+					z[k + 1] = std::numeric_limits<double>::max();
+				}
+
+				// Evaluate it:
+				uint16_t* out = &m_likelihoodDistanceTransform[cy * W];
+				k = 0;
+				for (int q = 0; q < W; q++)
+				{
+					while (z[k + 1] < q) k++;
+					const double d2 = square(double(q - v[k])) + f[v[k]];
+					out[q] = static_cast<uint16_t>(std::min(d2, 65535.0));
+				}
+			}
+		}));
+	}
+	for (auto& f : futs) f.wait();
+	for (auto& f : futs) f.get();
+
+	updateDistanceTransformLUT();
+
+	MRPT_END
+}
+
+/*---------------------------------------------------------------
+				updateDistanceTransformLUT
+ ---------------------------------------------------------------*/
+void COccupancyGridMap2D::updateDistanceTransformLUT()
+{
+	const auto& lo = likelihoodOptions;
+	auto& lut = m_distanceTransformLUT;
+	if (!lut.lik.empty() && lut.resolution == resolution &&
+		lut.LF_stdHit == lo.LF_stdHit && lut.LF_zHit == lo.LF_zHit &&
+		lut.LF_zRandom == lo.LF_zRandom && lut.LF_maxRange == lo.LF_maxRange &&
+		lut.LF_maxCorrsDistance == lo.LF_maxCorrsDistance &&
+		lut.LF_useSquareDist == lo.LF_useSquareDist)
+		return;  // Up to date
+
+	// Same operations than in computeLikelihoodField_Thrun_cell(), so the
+	// results are identical:
+	const float zHit = lo.LF_zHit;
+	const float zRandomTerm = lo.LF_zRandom / lo.LF_maxRange;
+	const float Q = -0.5f / square(lo.LF_stdHit);
+	const double maxCorrDist_sq = square(lo.LF_maxCorrsDistance);
+	const double _resolution = resolution;
+	const double constDist2DiscrUnits = 100 / (_resolution * _resolution);
+	const double constDist2DiscrUnits_INV = 1.0 / constDist2DiscrUnits;
+	const unsigned int maxDistInt =
+		mrpt::round(maxCorrDist_sq * constDist2DiscrUnits);
+
+	// Squared distances (in cells^2) from this one on all give the minimum
+	// likelihood:
+	const size_t nDists =
+		std::min<size_t>(0xFFFF, (maxDistInt + 99) / 100) + 1;
+	lut.lik.resize(nDists + 1);
+	for (size_t i = 0; i < nDists; i++)
+	{
+		float occupiedMinDist =
+			std::min(static_cast<unsigned int>(100 * i), maxDistInt) *
+			constDist2DiscrUnits_INV;
+		if (lo.LF_useSquareDist) occupiedMinDist *= occupiedMinDist;
+		lut.lik[i] = zRandomTerm + zHit * exp(Q * occupiedMinDist);
+	}
+	// Out of the grid, as in computeLikelihoodField_Thrun():
+	lut.lik[nDists] = zRandomTerm + zHit * exp(Q * maxCorrDist_sq);
+
+	lut.logLik.resize(lut.lik.size());
+	for (size_t i = 0; i < lut.lik.size(); i++)
+		lut.logLik[i] = log(lut.lik[i]);
+
+	lut.resolution = resolution;
+	lut.LF_stdHit = lo.LF_stdHit;
+	lut.LF_zHit = lo.LF_zHit;
+	lut.LF_zRandom = lo.LF_zRandom;
+	lut.LF_maxRange = lo.LF_maxRange;
+	lut.LF_maxCorrsDistance = lo.LF_maxCorrsDistance;
+	lut.LF_useSquareDist = lo.LF_useSquareDist;
+}
+
+namespace
+{
+/** Sum of `cellLogLik(idx)` for all the points (xs,ys), given in cell
+ * units in a frame with origin at (ox,oy) (cell units) and rotated by
+ * (ccos,ssin), where `idx` is the index of the cell where each point falls,
+ * or `outOfGrid` for points out of the grid (or in its last row or
+ * column). */
+template <class CELL_LOGLIK>
+double sumLikelihoodFieldLogLiks(
+	const std::vector<float>& xs, const std::vector<float>& ys,
+	const float ccos, const float ssin, const float ox, const float oy,
+	const int size_x, const int size_y, const int outOfGrid,
+	CELL_LOGLIK&& cellLogLik)
+{
+	const size_t nPts = xs.size();
+	const int size_x_1 = size_x - 1;
+	const int size_y_1 = size_y - 1;
+
+	double ret = 0;
+	size_t j = 0;
+#if MRPT_HAS_SSE2
+	const __m128 ccos4 = _mm_set1_ps(ccos), ssin4 = _mm_set1_ps(ssin);
+	const __m128 ox4 = _mm_set1_ps(ox), oy4 = _mm_set1_ps(oy);
+	const __m128i minus1 = _mm_set1_epi32(-1);
+	const __m128i size_x_1_4 = _mm_set1_epi32(size_x_1);
+	const __m128i size_y_1_4 = _mm_set1_epi32(size_y_1);
+	alignas(16) int32_t cxs[4], cys[4], inside[4];
+	for (; j + 4 <= nPts; j += 4)
+	{
+		const __m128 lx = _mm_loadu_ps(&xs[j]), ly = _mm_loadu_ps(&ys[j]);
+		// Truncation, as in x2idx(). Too large values become INT_MIN:
+		const __m128i cx = _mm_cvttps_epi32(_mm_add_ps(
+			ox4, _mm_sub_ps(_mm_mul_ps(lx, ccos4), _mm_mul_ps(ly, ssin4))));
+		const __m128i cy = _mm_cvttps_epi32(_mm_add_ps(
+			oy4, _mm_add_ps(_mm_mul_ps(lx, ssin4), _mm_mul_ps(ly, ccos4))));
+		// 0 <= cx < size_x-1 && 0 <= cy < size_y-1 :
+		const __m128i in = _mm_and_si128(
+			_mm_and_si128(
+				_mm_cmpgt_epi32(cx, minus1), _mm_cmplt_epi32(cx, size_x_1_4)),
+			_mm_and_si128(
+				_mm_cmpgt_epi32(cy, minus1), _mm_cmplt_epi32(cy, size_y_1_4)));
+		_mm_store_si128(reinterpret_cast<__m128i*>(cxs), cx);
+		_mm_store_si128(reinterpret_cast<__m128i*>(cys), cy);
+		_mm_store_si128(reinterpret_cast<__m128i*>(inside), in);
+		for (int q = 0; q < 4; q++)
+			ret += cellLogLik(
+				inside[q] ? cxs[q] + cys[q] * size_x : outOfGrid);
+	}
+#endif
+	// Remaining points (all of them, without SSE2):
+	for (; j < nPts; j++)
+	{
+		const int cx = static_cast<int>(ox + (xs[j] * ccos - ys[j] * ssin));
+		const int cy = static_cast<int>(oy + (xs[j] * ssin + ys[j] * ccos));
+		const bool in =
+			cx >= 0 && cx < size_x_1 && cy >= 0 && cy < size_y_1;
+		ret += cellLogLik(in ? cx + cy * size_x : outOfGrid);
+	}
+	return ret;
+}
+}  // namespace
+
+/*---------------------------------------------------------------
+			computeLikelihoodField_Thrun (batch version)
+ ---------------------------------------------------------------*/
+void COccupancyGridMap2D::computeLikelihoodField_Thrun(
+	const CPointsMap* pm, const std::vector<TPose2D>& relativePoses,
+	std::vector<double>& out_logLiks)
+{
+	MRPT_START
+
+	const size_t nPoses = relativePoses.size();
+	out_logLiks.resize(nPoses);
+
+	const size_t N = pm->size();
+	// Fill in the whole cache (or the static map tables):
+	if (N && !likelihoodOptions.LF_alternateAverageMethod)
+		precomputeLikelihoodFieldCache();
+	const bool staticMapMode = isDistanceTransformValid();
+
+	if (!N || likelihoodOptions.LF_alternateAverageMethod ||
+		(!staticMapMode && !likelihoodOptions.enableLikelihoodCache))
+	{
+		// No vectorized version for these cases:
+		for (size_t k = 0; k < nPoses; k++)
+		{
+			const CPose2D pose(relativePoses[k]);
+			out_logLiks[k] = computeLikelihoodField_Thrun(pm, &pose);
+		}
+		return;
+	}
+
+	// Decimated points, in cell units:
+	const int decimation = N < 10 ? 1 : likelihoodOptions.LF_decimation;
+	const float invRes = 1.0f / resolution;
+	std::vector<float> xs, ys;
+	xs.reserve(N / decimation + 1);
+	ys.reserve(N / decimation + 1);
+	for (size_t j = 0; j < N; j += decimation)
+	{
+		float x, y;
+		pm->getPoint(j, x, y);
+		xs.push_back(x * invRes);
+		ys.push_back(y * invRes);
+	}
+
+	// Index of the entry for cells out of the grid:
+	const int outOfGrid = static_cast<int>(map.size());
+	const auto& lut = m_distanceTransformLUT;
+	const size_t lutOutOfGrid = lut.lik.size() - 1;
+	const uint16_t lutMaxDist = static_cast<uint16_t>(lutOutOfGrid - 1);
+
+	for (size_t k = 0; k < nPoses; k++)
+	{
+		const TPose2D& pose = relativePoses[k];
+		const float ccos = static_cast<float>(cos(pose.phi));
+		const float ssin = static_cast<float>(sin(pose.phi));
+		// Pose origin, in (continuous) cell units:
+		const float ox = static_cast<float>((pose.x - x_min) / resolution);
+		const float oy = static_cast<float>((pose.y - y_min) / resolution);
+
+		if (staticMapMode)
+		{
+			const uint16_t* dist = &m_likelihoodDistanceTransform[0];
+			const double* logLik = &lut.logLik[0];
+			out_logLiks[k] = sumLikelihoodFieldLogLiks(
+				xs, ys, ccos, ssin, ox, oy, size_x, size_y, outOfGrid,
+				[=](int idx) {
+					return logLik
+						[idx == outOfGrid ? lutOutOfGrid
+										  : std::min(dist[idx], lutMaxDist)];
+				});
+		}
+		else
+		{
+			const float* logLik = &precomputedLogLikelihood[0];
+			out_logLiks[k] = sumLikelihoodFieldLogLiks(
+				xs, ys, ccos, ssin, ox, oy, size_x, size_y, outOfGrid,
+				[=](int idx) { return logLik[idx]; });
+		}
+	}
+
+	MRPT_END
+}
+
+/*---------------------------------------------------------------
+				computeObservationLikelihoodBatch
+ ---------------------------------------------------------------*/
+bool COccupancyGridMap2D::computeObservationLikelihoodBatch(
+	const CObservation* obs, const std::vector<TPose2D>& takenFrom,
+	std::vector<double>& out_logLiks)
+{
+	MRPT_START
+
+	if ((likelihoodOptions.likelihoodMethod != lmLikelihoodField_Thrun &&
+		 likelihoodOptions.likelihoodMethod != lmRayTracing) ||
+		!IS_CLASS(obs, CObservation2DRangeScan))
+		return false;
+
+	// Same checks than computeObservationLikelihood():
+	if (!genericMapParams.enableObservationLikelihood)
+	{
+		out_logLiks.assign(takenFrom.size(), 0);
+		return true;
+	}
+	const CObservation2DRangeScan* o =
+		static_cast<const CObservation2DRangeScan*>(obs);
+	if (!o->isPlanarScan(insertionOptions.horizontalTolerance) ||
+		(insertionOptions.useMapAltitude &&
+		 fabs(insertionOptions.mapAltitude - o->sensorPose.z()) > 0.01))
+	{
+		out_logLiks.assign(takenFrom.size(), -10);
+		return true;
+	}
+
+	if (likelihoodOptions.likelihoodMethod == lmRayTracing)
+	{
+		// Same than computeObservationLikelihood_rayTracing(), with all the
+		// scans simulated at once:
+		const unsigned int decimation = likelihoodOptions.rayTracing_decimation;
+		const size_t nRays = o->scan.size();
+		std::vector<float> simRanges;
+		std::vector<char> simValid;
+		laserScanSimulatorBatch(
+			*o, takenFrom, simRanges, simValid, 0.45f, nRays, decimation);
+
+		const size_t nOut = (nRays + decimation - 1) / decimation;
+		const double stdSqrt2 =
+			sqrt(2.0f) * likelihoodOptions.rayTracing_stdHit;
+		out_logLiks.assign(takenFrom.size(), 1.0);
+		for (size_t p = 0; p < takenFrom.size(); p++)
+		{
+			const float* r_sim = &simRanges[p * nOut];
+			for (size_t j = 0, k = 0; j < nRays; j += decimation, k++)
+			{
+				if (!o->validRange[j]) continue;
+				const double likelihood =
+					0.1 / o->maxRange +
+					0.9 * exp(-square(
+							  min((float)fabs(r_sim[k] - o->scan[j]), 2.0f) /
+							  stdSqrt2));
+				out_logLiks[p] += log(likelihood);
+			}
+		}
+		return true;
+	}
+
+	// Same points than computeObservationLikelihood_likelihoodField_Thrun():
+	CPointsMap::TInsertionOptions opts;
+	opts.minDistBetweenLaserPoints = resolution * 0.5f;
+	opts.isPlanarMap = true;
+	opts.horizontalTolerance = insertionOptions.horizontalTolerance;
+
+	computeLikelihoodField_Thrun(
+		o->buildAuxPointsMap<mrpt::maps::CPointsMap>(&opts), takenFrom,
+		out_logLiks);
+	return true;
+
+	MRPT_END
+}
+
 /*---------------------------------------------------------------
 					computeLikelihoodField_II
  ---------------------------------------------------------------*/
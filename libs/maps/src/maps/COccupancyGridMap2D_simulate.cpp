@@ -14,11 +14,14 @@
 #include <mrpt/obs/CObservationRange.h>
 #include <mrpt/core/round.h>  // round()
 #include <mrpt/math/transform_gaussian.h>
+#include <mrpt/math/wrap2pi.h>
+#include <mrpt/system/CWorkerThreadsPool.h>
 
 #include <mrpt/random.h>
 
 using namespace mrpt;
 using namespace mrpt::maps;
+using namespace mrpt::math;
 using namespace mrpt::obs;
 using namespace mrpt::random;
 using namespace mrpt::poses;
@@ -45,19 +48,20 @@ void COccupancyGridMap2D::laserScanSimulator(
 	// Scan size:
 	inout_Scan.resizeScan(N);
 
-	double A = sensorPose.phi() +
-			   (inout_Scan.rightToLeft ? -0.5 : +0.5) * inout_Scan.aperture;
+	const double A0 = sensorPose.phi() +
+					  (inout_Scan.rightToLeft ? -0.5 : +0.5) *
+						  inout_Scan.aperture;
 	const double AA =
 		(inout_Scan.rightToLeft ? 1.0 : -1.0) * (inout_Scan.aperture / (N - 1));
 
 	const float free_thres = 1.0f - threshold;
 
-	for (size_t i = 0; i < N; i += decimation, A += AA * decimation)
+	for (size_t i = 0; i < N; i += decimation)
 	{
 		bool valid;
 		float out_range;
 		simulateScanRay(
-			sensorPose.x(), sensorPose.y(), A, out_range, valid,
+			sensorPose.x(), sensorPose.y(), A0 + AA * i, out_range, valid,
 			inout_Scan.maxRange, free_thres, noiseStd, angleNoiseStd);
 		inout_Scan.setScanRange(i, out_range);
 		inout_Scan.setScanRangeValidity(i, valid);
@@ -66,6 +70,79 @@ void COccupancyGridMap2D::laserScanSimulator(
 	MRPT_END
 }
 
+// See docs in header
+void COccupancyGridMap2D::laserScanSimulatorBatch(
+	const mrpt::obs::CObservation2DRangeScan& scanParams,
+	const std::vector<TPose2D>& robotPoses, std::vector<float>& out_ranges,
+	std::vector<char>& out_valid, float threshold, size_t N,
+	unsigned int decimation) const
+{
+	MRPT_START
+
+	ASSERT_(decimation >= 1);
+	ASSERT_(N >= 2);
+
+	const size_t nPoses = robotPoses.size();
+	const size_t nOut = (N + decimation - 1) / decimation;
+	const size_t nTotal = nPoses * nOut;
+	out_ranges.resize(nTotal);
+	out_valid.resize(nTotal);
+	if (!nTotal) return;
+
+	// Sensor poses in global coordinates, computed as in
+	// laserScanSimulator():
+	std::vector<TPose2D> sensorPoses(nPoses);
+	for (size_t p = 0; p < nPoses; p++)
+		sensorPoses[p] =
+			CPose2D(
+				CPose3D(CPose2D(robotPoses[p])) + scanParams.sensorPose)
+				.asTPose();
+
+	const double A0 = (scanParams.rightToLeft ? -0.5 : +0.5) *
+					  scanParams.aperture;
+	const double AA = (scanParams.rightToLeft ? 1.0 : -1.0) *
+					  (scanParams.aperture / (N - 1));
+	const double maxRange = scanParams.maxRange;
+	const cellType thresholdFree = p2l(1.0f - threshold);
+	const bool useLUT = canUseRayCastLUT(thresholdFree, maxRange);
+
+	// Each task simulates a range [k0,k1) of the output rays:
+	auto simulRays = [&](const size_t k0, const size_t k1) {
+		for (size_t k = k0; k < k1; k++)
+		{
+			const TPose2D& sp = sensorPoses[k / nOut];
+			const double A = sp.phi + A0 + AA * ((k % nOut) * decimation);
+			float range;
+			bool valid;
+			if (useLUT)
+				rayCastLUTLookup(sp.x, sp.y, A, maxRange, range, valid);
+			else
+				rayTraceDDA(
+					sp.x, sp.y, cos(A), sin(A), maxRange, thresholdFree, range,
+					valid);
+			out_ranges[k] = range;
+			out_valid[k] = valid ? 1 : 0;
+		}
+	};
+
+	const size_t RAYS_PER_TASK = 2048;
+	const size_t nThreads = std::thread::hardware_concurrency();
+	if (nThreads <= 1 || nTotal <= RAYS_PER_TASK)
+	{
+		simulRays(0, nTotal);
+		return;
+	}
+	mrpt::system::CWorkerThreadsPool pool(nThreads);
+	std::vector<std::future<void>> futs;
+	for (size_t k0 = 0; k0 < nTotal; k0 += RAYS_PER_TASK)
+		futs.emplace_back(pool.enqueue(
+			simulRays, k0, std::min(nTotal, k0 + RAYS_PER_TASK)));
+	for (auto& f : futs) f.wait();
+	for (auto& f : futs) f.get();
+
+	MRPT_END
+}
+
 void COccupancyGridMap2D::sonarSimulator(
 	CObservationRange& inout_observation, const CPose2D& robotPose,
 	float threshold, float rangeNoiseStd, float angleNoiseStd) const
@@ -118,66 +195,175 @@ void COccupancyGridMap2D::simulateScanRay(
 			 ? getRandomGenerator().drawGaussian1D_normalized() * angleNoiseStd
 			 : .0);
 
-// Unit vector in the directorion of the ray:
-#ifdef HAVE_SINCOS
-	double Arx, Ary;
-	::sincos(A_, &Ary, &Arx);
-#else
-	const double Arx = cos(A_);
-	const double Ary = sin(A_);
-#endif
-
-	// Ray tracing, until collision, out of the map or out of range:
-	const unsigned int max_ray_len = mrpt::round(max_range_meters / resolution);
-	unsigned int ray_len = 0;
-
-// Use integers for all ray tracing for efficiency
-#define INTPRECNUMBIT 10
-#define int_x2idx(_X) (_X >> INTPRECNUMBIT)
-#define int_y2idx(_Y) (_Y >> INTPRECNUMBIT)
-
-	int64_t rxi = static_cast<int64_t>(
-		((start_x - x_min) / resolution) * (1L << INTPRECNUMBIT));
-	int64_t ryi = static_cast<int64_t>(
-		((start_y - y_min) / resolution) * (1L << INTPRECNUMBIT));
-
-	const int64_t Arxi = static_cast<int64_t>(
-		RAYTRACE_STEP_SIZE_IN_CELL_UNITS * Arx * (1L << INTPRECNUMBIT));
-	const int64_t Aryi = static_cast<int64_t>(
-		RAYTRACE_STEP_SIZE_IN_CELL_UNITS * Ary * (1L << INTPRECNUMBIT));
-
-	cellType hitCellOcc_int = 0;  // p2l(0.5f)
 	const cellType threshold_free_int = p2l(threshold_free);
-	int x, y = int_y2idx(ryi);
+	if (canUseRayCastLUT(threshold_free_int, max_range_meters))
+		rayCastLUTLookup(
+			start_x, start_y, A_, max_range_meters, out_range, out_valid);
+	else
+		rayTraceDDA(
+			start_x, start_y, cos(A_), sin(A_), max_range_meters,
+			threshold_free_int, out_range, out_valid);
+
+	// Add additive Gaussian noise:
+	if (noiseStd > 0 && out_valid)
+		out_range +=
+			noiseStd * getRandomGenerator().drawGaussian1D_normalized();
+}
 
-	while ((x = int_x2idx(rxi)) >= 0 && (y = int_y2idx(ryi)) >= 0 &&
-		   x < static_cast<int>(size_x) && y < static_cast<int>(size_y) &&
-		   (hitCellOcc_int = map[x + y * size_x]) > threshold_free_int &&
-		   ray_len < max_ray_len)
+void COccupancyGridMap2D::rayTraceDDA(
+	const double x, const double y, const double cosA, const double sinA,
+	const double maxRange, const cellType thresholdFree, float& out_range,
+	bool& out_valid) const
+{
+	out_valid = false;
+	out_range = maxRange;
+
+	// Ray origin, in cell units:
+	const double sx = (x - x_min) / resolution;
+	const double sy = (y - y_min) / resolution;
+	int cx = static_cast<int>(std::floor(sx));
+	int cy = static_cast<int>(std::floor(sy));
+	// Tip: if cx<0, (unsigned)(cx) will also be >>> size_x ;-)
+	if (static_cast<unsigned>(cx) >= size_x ||
+		static_cast<unsigned>(cy) >= size_y)
+		return;
+
+	// Ray parameter (distance, in cell units) at which the next vertical
+	// (tMaxX) and horizontal (tMaxY) cell borders are crossed, and their
+	// increments from one border to the next one:
+	const double INF = std::numeric_limits<double>::max();
+	const int stepX = cosA >= 0 ? 1 : -1, stepY = sinA >= 0 ? 1 : -1;
+	const double tDeltaX = cosA != 0 ? std::abs(1.0 / cosA) : INF;
+	const double tDeltaY = sinA != 0 ? std::abs(1.0 / sinA) : INF;
+	double tMaxX = cosA != 0 ? (cx + (stepX > 0 ? 1 : 0) - sx) / cosA : INF;
+	double tMaxY = sinA != 0 ? (cy + (stepY > 0 ? 1 : 0) - sy) / sinA : INF;
+
+	const double maxT = maxRange / resolution;
+	double t = 0;
+	for (;;)
 	{
-		rxi += Arxi;
-		ryi += Aryi;
-		ray_len++;
+		const cellType c = map[cx + cy * size_x];
+		if (c <= thresholdFree)
+		{
+			// Hitting an unknown cell does not give a valid range:
+			if (std::abs(c) > 1)
+			{
+				out_range = t * resolution;
+				out_valid = true;
+			}
+			return;
+		}
+		if (tMaxX < tMaxY)
+		{
+			t = tMaxX;
+			tMaxX += tDeltaX;
+			cx += stepX;
+			if (static_cast<unsigned>(cx) >= size_x) return;
+		}
+		else
+		{
+			t = tMaxY;
+			tMaxY += tDeltaY;
+			cy += stepY;
+			if (static_cast<unsigned>(cy) >= size_y) return;
+		}
+		if (t >= maxT) return;
 	}
+}
+
+bool COccupancyGridMap2D::canUseRayCastLUT(
+	const cellType thresholdFree, const double maxRange) const
+{
+	return isRayCastLUTValid() && m_rayCastLUT.thresholdFree == thresholdFree &&
+		   maxRange <= m_rayCastLUT.maxRange;
+}
+
+void COccupancyGridMap2D::rayCastLUTLookup(
+	const double x, const double y, const double angle, const double maxRange,
+	float& out_range, bool& out_valid) const
+{
+	out_valid = false;
+	out_range = maxRange;
+
+	const int cx = static_cast<int>(std::floor((x - x_min) / resolution));
+	const int cy = static_cast<int>(std::floor((y - y_min) / resolution));
+	if (static_cast<unsigned>(cx) >= size_x ||
+		static_cast<unsigned>(cy) >= size_y)
+		return;
+
+	const unsigned int nAngles = m_rayCastLUT.nAngles;
+	const unsigned int a = static_cast<unsigned int>(
+		mrpt::round(mrpt::math::wrapTo2Pi(angle) * nAngles / (2 * M_PI)));
+	const uint16_t r =
+		m_rayCastLUT.ranges[(cx + cy * size_x) * nAngles + a % nAngles];
+	if (r == 0xFFFF) return;
+
+	const float range = r * (m_rayCastLUT.maxRange / 65534);
+	if (range >= maxRange) return;
+	out_range = range;
+	out_valid = true;
+}
+
+void COccupancyGridMap2D::precomputeRayCastLUT(
+	unsigned int nAngles, float maxRange, float threshold)
+{
+	MRPT_START
+
+	ASSERT_(nAngles > 0);
+	ASSERT_(maxRange > 0);
+
+	resetLikelihoodCachesIfOutdated();
 
-	// Store:
-	// Check out of the grid?
-	// Tip: if x<0, (unsigned)(x) will also be >>> size_x ;-)
-	if (abs(hitCellOcc_int) <= 1 || static_cast<unsigned>(x) >= size_x ||
-		static_cast<unsigned>(y) >= size_y)
+	m_rayCastLUT.nAngles = nAngles;
+	m_rayCastLUT.maxRange = maxRange;
+	m_rayCastLUT.thresholdFree = p2l(1.0f - threshold);
+	m_rayCastLUT.ranges.resize(map.size() * nAngles);
+
+	std::vector<double> cosA(nAngles), sinA(nAngles);
+	for (unsigned int a = 0; a < nAngles; a++)
 	{
-		out_valid = false;
-		out_range = max_range_meters;
+		cosA[a] = cos(a * 2 * M_PI / nAngles);
+		sinA[a] = sin(a * 2 * M_PI / nAngles);
 	}
-	else
-	{  // No: The normal case:
-		out_range = RAYTRACE_STEP_SIZE_IN_CELL_UNITS * ray_len * resolution;
-		out_valid = (ray_len < max_ray_len);  // out_range<max_range_meters;
-		// Add additive Gaussian noise:
-		if (noiseStd > 0 && out_valid)
-			out_range +=
-				noiseStd * getRandomGenerator().drawGaussian1D_normalized();
+	const double scale = 65534 / maxRange;
+
+	// Each task fills a block of rows:
+	const unsigned int ROWS_PER_TASK = 8;
+	mrpt::system::CWorkerThreadsPool pool;
+	std::vector<std::future<void>> futs;
+	for (unsigned int cy0 = 0; cy0 < size_y; cy0 += ROWS_PER_TASK)
+	{
+		const unsigned int cy1 = std::min(size_y, cy0 + ROWS_PER_TASK);
+		futs.emplace_back(pool.enqueue([&, cy0, cy1]() {
+			for (unsigned int cy = cy0; cy < cy1; cy++)
+				for (unsigned int cx = 0; cx < size_x; cx++)
+				{
+					uint16_t* out = &m_rayCastLUT.ranges[(cx + cy * size_x) *
+														 nAngles];
+					const double x = idx2x(cx), y = idx2y(cy);
+					for (unsigned int a = 0; a < nAngles; a++)
+					{
+						float range;
+						bool valid;
+						rayTraceDDA(
+							x, y, cosA[a], sinA[a], maxRange,
+							m_rayCastLUT.thresholdFree, range, valid);
+						out[a] = valid ? static_cast<uint16_t>(std::min(
+											 65534.0, range * scale + 0.5))
+									   : 0xFFFF;
+					}
+				}
+		}));
 	}
+	for (auto& f : futs) f.wait();
+	for (auto& f : futs) f.get();
+
+	MRPT_END
+}
+
+void COccupancyGridMap2D::clearRayCastLUT()
+{
+	m_rayCastLUT = TRayCastLUT();
 }
 
 COccupancyGridMap2D::TLaserSimulUncertaintyParams::
@@ -9,6 +9,10 @@
 
 #include <mrpt/maps/COccupancyGridMap2D.h>
 #include <mrpt/obs/CObservation2DRangeScan.h>
+#include <mrpt/io/CMemoryStream.h>
+#include <mrpt/serialization/CArchive.h>
+#include <mrpt/poses/CPose3D.h>
+#include <mrpt/random.h>
 #include <gtest/gtest.h>
 
 using namespace mrpt;
@@ -18,7 +22,9 @@ using namespace mrpt::poses;
 using namespace mrpt::math;
 using namespace std;
 
-TEST(COccupancyGridMap2DTests, insert2DScan)
+namespace
+{
+void loadTestScan(CObservation2DRangeScan& scan1)
 {
 	float SCAN_RANGES_1[] = {
 		0.910f,  0.900f,  0.910f,  0.900f,  0.900f,  0.890f,  0.890f,  0.880f,
@@ -87,13 +93,19 @@ TEST(COccupancyGridMap2DTests, insert2DScan)
 
 	const size_t SCAN_SIZE = sizeof(SCAN_RANGES_1) / sizeof(SCAN_RANGES_1[0]);
 
-	// Load scans:
-	mrpt::obs::CObservation2DRangeScan scan1;
 	scan1.aperture = M_PIf;
 	scan1.rightToLeft = true;
 	ASSERT_(sizeof(SCAN_RANGES_1) == sizeof(float) * SCAN_SIZE);
 
 	scan1.loadFromVectors(SCAN_SIZE, SCAN_RANGES_1, SCAN_VALID_1);
+}
+}  // namespace
+
+TEST(COccupancyGridMap2DTests, insert2DScan)
+{
+	// Load scans:
+	mrpt::obs::CObservation2DRangeScan scan1;
+	loadTestScan(scan1);
 
 	// Insert the scan in the grid map and check expected values:
 	{
@@ -104,3 +116,303 @@ TEST(COccupancyGridMap2DTests, insert2DScan)
 		// should have a high "freeness"
 	}
 }
+
+TEST(COccupancyGridMap2DTests, likelihoodFieldBatch)
+{
+	mrpt::obs::CObservation2DRangeScan scan1;
+	loadTestScan(scan1);
+
+	COccupancyGridMap2D grid(-20.0f, 20.0f, -20.0f, 20.0f, 0.05f);
+	grid.insertObservation(&scan1);
+
+	auto& rng = mrpt::random::getRandomGenerator();
+	rng.randomize(1234);
+	std::vector<TPose2D> poses;
+	for (int i = 0; i < 300; i++)
+		poses.emplace_back(
+			rng.drawUniform(-2.0, 2.0), rng.drawUniform(-2.0, 2.0),
+			rng.drawUniform(-M_PI, M_PI));
+	// Some poses with points out of the grid:
+	poses.emplace_back(19.0, 0, 0);
+	poses.emplace_back(-25.0, 30.0, 1.0);
+
+	for (int decimation : {1, 5})
+	{
+		for (bool altMethod : {false, true})
+		{
+			grid.likelihoodOptions.LF_decimation = decimation;
+			grid.likelihoodOptions.LF_alternateAverageMethod = altMethod;
+
+			std::vector<double> batchLiks;
+			ASSERT_TRUE(
+				grid.computeObservationLikelihoodBatch(
+					&scan1, poses, batchLiks));
+			ASSERT_EQ(batchLiks.size(), poses.size());
+
+			for (size_t i = 0; i < poses.size(); i++)
+			{
+				const double lik = grid.computeObservationLikelihood(
+					&scan1, CPose3D(CPose2D(poses[i])));
+				// Single precision may only change the cell of a few points
+				// lying right on a cell border:
+				EXPECT_NEAR(lik, batchLiks[i], 1e-3 * std::abs(lik) + 1e-3)
+					<< "decimation=" << decimation << " alt=" << altMethod
+					<< " pose=" << poses[i].asString();
+			}
+		}
+	}
+
+	// Unsupported likelihood method:
+	grid.likelihoodOptions.likelihoodMethod =
+		COccupancyGridMap2D::lmConsensus;
+	std::vector<double> batchLiks;
+	EXPECT_FALSE(
+		grid.computeObservationLikelihoodBatch(&scan1, poses, batchLiks));
+}
+
+TEST(COccupancyGridMap2DTests, distanceTransform)
+{
+	auto& rng = mrpt::random::getRandomGenerator();
+	rng.randomize(4321);
+
+	COccupancyGridMap2D grid(0.0f, 4.1f, 0.0f, 2.3f, 0.1f);
+	const int W = grid.getSizeX(), H = grid.getSizeY();
+
+	// Without obstacles, all distances saturate:
+	grid.precomputeDistanceTransform();
+	ASSERT_TRUE(grid.isDistanceTransformValid());
+	EXPECT_EQ(grid.getDistanceTransformSqr(0, 0), 0xFFFF);
+	EXPECT_EQ(grid.getDistanceTransformSqr(W - 1, H - 1), 0xFFFF);
+
+	for (int i = 0; i < 15; i++)
+		grid.setCell(
+			rng.drawUniform32bit() % W, rng.drawUniform32bit() % H, 0.1f);
+	grid.precomputeDistanceTransform();
+	ASSERT_TRUE(grid.isDistanceTransformValid());
+
+	for (int cy = 0; cy < H; cy++)
+		for (int cx = 0; cx < W; cx++)
+		{
+			int best = 0xFFFF;
+			for (int y = 0; y < H; y++)
+				for (int x = 0; x < W; x++)
+					if (grid.getCell(x, y) < 0.5f)
+						best = std::min(best, square(x - cx) + square(y - cy));
+			EXPECT_EQ(grid.getDistanceTransformSqr(cx, cy), best)
+				<< "cx=" << cx << " cy=" << cy;
+		}
+}
+
+TEST(COccupancyGridMap2DTests, likelihoodFieldStaticMapMode)
+{
+	mrpt::obs::CObservation2DRangeScan scan1;
+	loadTestScan(scan1);
+
+	COccupancyGridMap2D grid(-20.0f, 20.0f, -20.0f, 20.0f, 0.05f);
+	grid.insertObservation(&scan1);
+	grid.likelihoodOptions.LF_maxCorrsDistance = 0.4f;
+
+	auto& rng = mrpt::random::getRandomGenerator();
+	rng.randomize(1234);
+	std::vector<TPose2D> poses;
+	for (int i = 0; i < 100; i++)
+		poses.emplace_back(
+			rng.drawUniform(-2.0, 2.0), rng.drawUniform(-2.0, 2.0),
+			rng.drawUniform(-M_PI, M_PI));
+	poses.emplace_back(19.0, 0, 0);
+
+	struct TCase
+	{
+		bool altMethod, squareDist;
+	};
+	const TCase cases[] = {{false, false}, {true, false}, {false, true}};
+
+	// Reference values, from the regular mode. Each case uses its own copy,
+	// since the lazy cache is not discarded when options change:
+	std::vector<std::vector<double>> refLiks;
+	for (const auto& c : cases)
+	{
+		COccupancyGridMap2D refGrid = grid;
+		refGrid.likelihoodOptions.LF_alternateAverageMethod = c.altMethod;
+		refGrid.likelihoodOptions.LF_useSquareDist = c.squareDist;
+		refLiks.emplace_back();
+		for (const auto& p : poses)
+			refLiks.back().push_back(refGrid.computeObservationLikelihood(
+				&scan1, CPose3D(CPose2D(p))));
+	}
+
+	grid.precomputeDistanceTransform();
+	ASSERT_TRUE(grid.isDistanceTransformValid());
+
+	// Save and reload, which must keep the static map mode:
+	COccupancyGridMap2D grid2;
+	{
+		mrpt::io::CMemoryStream buf;
+		auto arch = mrpt::serialization::archiveFrom(buf);
+		arch << grid;
+		buf.Seek(0);
+		arch >> grid2;
+	}
+	ASSERT_TRUE(grid2.isDistanceTransformValid());
+
+	// Inserting new observations leaves the static map mode:
+	{
+		COccupancyGridMap2D grid3 = grid;
+		grid3.insertObservation(&scan1);
+		EXPECT_FALSE(grid3.isDistanceTransformValid());
+	}
+
+	for (auto g : {&grid, &grid2})
+	{
+		for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++)
+		{
+			g->likelihoodOptions.LF_alternateAverageMethod =
+				cases[c].altMethod;
+			g->likelihoodOptions.LF_useSquareDist = cases[c].squareDist;
+			std::vector<double> batchLiks;
+			ASSERT_TRUE(
+				g->computeObservationLikelihoodBatch(&scan1, poses, batchLiks));
+			for (size_t i = 0; i < poses.size(); i++)
+			{
+				const double lik = g->computeObservationLikelihood(
+					&scan1, CPose3D(CPose2D(poses[i])));
+				EXPECT_DOUBLE_EQ(lik, refLiks[c][i]) << "case=" << c;
+				EXPECT_NEAR(lik, batchLiks[i], 1e-3 * std::abs(lik) + 1e-3)
+					<< "case=" << c;
+			}
+		}
+	}
+}
+
+TEST(COccupancyGridMap2DTests, simulateScanRayDDA)
+{
+	// A free 10x10m area with a wall at x=[6.0,6.1]:
+	COccupancyGridMap2D grid(0.0f, 10.0f, 0.0f, 10.0f, 0.1f);
+	grid.fill(1.0f);
+	for (int cy = 0; cy < static_cast<int>(grid.getSizeY()); cy++)
+		grid.setCell(grid.x2idx(6.05), cy, 0.0f);
+
+	float range;
+	bool valid;
+	for (const double ang : {0.0, 0.3, -0.5, 0.6})
+	{
+		grid.simulateScanRay(1.03, 5.02, ang, range, valid, 20.0);
+		EXPECT_TRUE(valid) << "ang=" << ang;
+		EXPECT_NEAR(range, (6.0 - 1.03) / cos(ang), 1e-4) << "ang=" << ang;
+	}
+
+	// Leaving the grid, or beyond the max range, gives invalid ranges:
+	grid.simulateScanRay(1.03, 5.02, M_PI, range, valid, 20.0);
+	EXPECT_FALSE(valid);
+	EXPECT_FLOAT_EQ(range, 20.0f);
+	grid.simulateScanRay(1.03, 5.02, 0.0, range, valid, 4.0);
+	EXPECT_FALSE(valid);
+	EXPECT_FLOAT_EQ(range, 4.0f);
+
+	// Starting within an obstacle:
+	grid.simulateScanRay(6.07, 5.02, 0.0, range, valid, 20.0);
+	EXPECT_TRUE(valid);
+	EXPECT_FLOAT_EQ(range, 0.0f);
+}
+
+TEST(COccupancyGridMap2DTests, laserScanSimulatorBatch)
+{
+	mrpt::obs::CObservation2DRangeScan scan1;
+	loadTestScan(scan1);
+
+	COccupancyGridMap2D grid(-20.0f, 20.0f, -20.0f, 20.0f, 0.05f);
+	grid.insertObservation(&scan1);
+
+	auto& rng = mrpt::random::getRandomGenerator();
+	rng.randomize(1234);
+	std::vector<TPose2D> poses;
+	for (int i = 0; i < 50; i++)
+		poses.emplace_back(
+			rng.drawUniform(-1.0, 1.0), rng.drawUniform(-1.0, 1.0),
+			rng.drawUniform(-M_PI, M_PI));
+
+	CObservation2DRangeScan simul;
+	simul.aperture = scan1.aperture;
+	simul.rightToLeft = scan1.rightToLeft;
+	simul.maxRange = 30.0f;
+	simul.sensorPose = CPose3D(0.2, 0.1, 0.3, 0.05, 0, 0);
+
+	std::vector<float> ranges;
+	std::vector<char> valids;
+	for (const unsigned int decimation : {1u, 3u})
+	{
+		const size_t N = 181, nOut = (N + decimation - 1) / decimation;
+		grid.laserScanSimulatorBatch(
+			simul, poses, ranges, valids, 0.6f, N, decimation);
+		ASSERT_EQ(ranges.size(), poses.size() * nOut);
+		ASSERT_EQ(valids.size(), poses.size() * nOut);
+
+		for (size_t p = 0; p < poses.size(); p++)
+		{
+			grid.laserScanSimulator(
+				simul, CPose2D(poses[p]), 0.6f, N, 0, decimation);
+			for (size_t k = 0; k < nOut; k++)
+			{
+				EXPECT_EQ(
+					simul.validRange[k * decimation], valids[p * nOut + k]);
+				EXPECT_EQ(simul.scan[k * decimation], ranges[p * nOut + k]);
+			}
+		}
+	}
+
+	// Batch likelihood for the beam model:
+	grid.likelihoodOptions.likelihoodMethod =
+		COccupancyGridMap2D::lmRayTracing;
+	std::vector<double> batchLiks;
+	ASSERT_TRUE(
+		grid.computeObservationLikelihoodBatch(&scan1, poses, batchLiks));
+	for (size_t p = 0; p < poses.size(); p++)
+		EXPECT_DOUBLE_EQ(
+			batchLiks[p], grid.computeObservationLikelihood(
+							  &scan1, CPose3D(CPose2D(poses[p]))));
+}
+
+TEST(COccupancyGridMap2DTests, rayCastLUT)
+{
+	mrpt::obs::CObservation2DRangeScan scan1;
+	loadTestScan(scan1);
+
+	COccupancyGridMap2D grid(-5.0f, 5.0f, -5.0f, 5.0f, 0.1f);
+	grid.insertObservation(&scan1);
+
+	// Exact ranges from the cell centers, before building the table:
+	const unsigned int nAngles = 90;
+	const float maxRange = 6.0f;
+	auto& rng = mrpt::random::getRandomGenerator();
+	rng.randomize(4321);
+	struct TQuery
+	{
+		double x, y, ang;
+		float range;
+		bool valid;
+	};
+	std::vector<TQuery> queries(200);
+	for (auto& q : queries)
+	{
+		q.x = grid.idx2x(rng.drawUniform32bit() % grid.getSizeX());
+		q.y = grid.idx2y(rng.drawUniform32bit() % grid.getSizeY());
+		q.ang = (rng.drawUniform32bit() % nAngles) * 2 * M_PI / nAngles;
+		grid.simulateScanRay(q.x, q.y, q.ang, q.range, q.valid, maxRange);
+	}
+
+	grid.precomputeRayCastLUT(nAngles, maxRange, 0.6f);
+	ASSERT_TRUE(grid.isRayCastLUTValid());
+
+	for (const auto& q : queries)
+	{
+		float range;
+		bool valid;
+		grid.simulateScanRay(q.x, q.y, q.ang, range, valid, maxRange);
+		EXPECT_EQ(valid, q.valid);
+		if (valid) EXPECT_NEAR(range, q.range, maxRange / 65534);
+	}
+
+	// Inserting new observations discards the table:
+	grid.insertObservation(&scan1);
+	EXPECT_FALSE(grid.isRayCastLUTValid());
+}
@@ -12,6 +12,7 @@
 #include <mrpt/config/CConfigFile.h>
 #include <mrpt/system/CTicTac.h>
 #include <mrpt/system/CTimeLogger.h>
+#include <mrpt/system/CWorkerThreadsPool.h>
 #include <mrpt/system/os.h>
 #include <mrpt/math/geometry.h>
 #include <mrpt/serialization/CArchive.h>
@@ -317,6 +318,59 @@ void CPointsMap::clipOutOfRange(const TPoint2D& p, float maxRange)
 	mark_as_modified();
 }
 
+namespace
+{
+/** Worker threads shared by all the points maps for the search of
+ * correspondences (see TMatchingParams::numThreads). Re-created if the
+ * number of threads changes. */
+std::shared_ptr<CWorkerThreadsPool> matchingThreadsPool(size_t nThreads)
+{
+	static std::mutex pool_mtx;
+	static std::shared_ptr<CWorkerThreadsPool> pool;
+	std::lock_guard<std::mutex> lock(pool_mtx);
+	if (!pool || pool->size() != nThreads)
+		pool = std::make_shared<CWorkerThreadsPool>(nThreads);
+	return pool;
+}
+
+/** Invokes `func(i0,i1)` for consecutive blocks [i0,i1) covering [0,N),
+ * in parallel if `numThreads!=1` (0 means one thread per core). The first
+ * block is processed in the calling thread before launching the others, so
+ * the KD-tree gets built (if needed) without races. */
+template <class FUNCTOR>
+void matchingParallelFor(
+	const unsigned int numThreads, const size_t N, FUNCTOR&& func)
+{
+	const size_t MIN_BLOCK_SIZE = 256;
+	const size_t nThreads =
+		numThreads != 0
+			? numThreads
+			: std::max<size_t>(1, std::thread::hardware_concurrency());
+	if (nThreads == 1 || N <= MIN_BLOCK_SIZE)
+	{
+		func(0, N);
+		return;
+	}
+	// A few blocks per thread, to balance the load:
+	const size_t blockSize =
+		std::max(MIN_BLOCK_SIZE, (N + 4 * nThreads - 1) / (4 * nThreads));
+	func(0, blockSize);
+
+	auto pool = matchingThreadsPool(nThreads);
+	std::vector<std::future<void>> futs;
+	for (size_t i0 = blockSize; i0 < N; i0 += blockSize)
+	{
+		const size_t i1 = std::min(N, i0 + blockSize);
+		futs.emplace_back(
+			pool->enqueue([&func, i0, i1]() { func(i0, i1); }));
+	}
+	// Wait for all tasks before re-throwing any exception, since they refer
+	// to local variables:
+	for (auto& f : futs) f.wait();
+	for (auto& f : futs) f.get();
+}
+}  // namespace
+
 void CPointsMap::determineMatching2D(
 	const mrpt::maps::CMetricMap* otherMap2, const CPose2D& otherMapPose_,
 	TMatchingPairList& correspondences, const TMatchingParams& params,
@@ -355,9 +409,6 @@ void CPointsMap::determineMatching2D(
 	float x_local, y_local;
 	unsigned int localIdx;
 
-	const float *x_other_it, *y_other_it,
-		*z_other_it;  // *x_global_it,*y_global_it; //,*z_global_it;
-
 	// Prepare output: no correspondences initially:
 	correspondences.clear();
 	correspondences.reserve(nLocalPoints);
@@ -509,34 +560,37 @@ void CPointsMap::determineMatching2D(
 		local_y_min > global_y_max || local_y_max < global_y_min)
 		return;  // We know for sure there is no matching at all
 
-	// Loop for each point in local map:
+	// Search the closest point in "this" (global/reference) map for each
+	// local point, with a KD-tree, storing the results in SoA buffers:
+	// --------------------------------------------------------------------
+	const size_t nQueries =
+		(nLocalPoints - params.offset_other_map_points +
+		 params.decimation_other_map_points - 1) /
+		params.decimation_other_map_points;
+	std::vector<size_t> closest_idxs(nQueries);
+	std::vector<float> closest_err_sqs(nQueries);
+
+	matchingParallelFor(
+		params.numThreads, nQueries, [&](const size_t i0, const size_t i1) {
+			const size_t idx0 = params.offset_other_map_points +
+								i0 * params.decimation_other_map_points;
+			kdTreeClosestPoint2DBatch(
+				&x_locals[idx0], &y_locals[idx0], i1 - i0, &closest_idxs[i0],
+				&closest_err_sqs[i0], params.decimation_other_map_points);
+		});
+
+	// Keep those below the distance threshold, in order:
 	// --------------------------------------------------
-	for (localIdx = params.offset_other_map_points,
-		x_other_it = &otherMap->x[params.offset_other_map_points],
-		y_other_it = &otherMap->y[params.offset_other_map_points],
-		z_other_it = &otherMap->z[params.offset_other_map_points];
-		 localIdx < nLocalPoints;
-		 x_other_it += params.decimation_other_map_points,
-		y_other_it += params.decimation_other_map_points,
-		z_other_it += params.decimation_other_map_points,
-		localIdx += params.decimation_other_map_points)
+	for (size_t k = 0; k < nQueries; k++)
 	{
+		localIdx = params.offset_other_map_points +
+				   k * params.decimation_other_map_points;
 		// For speed-up:
-		x_local = x_locals[localIdx];  // *x_locals_it;
-		y_local = y_locals[localIdx];  // *y_locals_it;
+		x_local = x_locals[localIdx];
+		y_local = y_locals[localIdx];
 
-		// Find all the matchings in the requested distance:
-
-		// KD-TREE implementation =================================
-		// Use a KD-tree to look for the nearnest neighbor of:
-		//   (x_local, y_local, z_local)
-		// In "this" (global/reference) points map.
-
-		float tentativ_err_sq;
-		unsigned int tentativ_this_idx = kdTreeClosestPoint2D(
-			x_local, y_local,  // Look closest to this guy
-			tentativ_err_sq  // save here the min. distance squared
-			);
+		const float tentativ_err_sq = closest_err_sqs[k];
+		const size_t tentativ_this_idx = closest_idxs[k];
 
 		// Compute max. allowed distance:
 		maxDistForCorrespondenceSquared = square(
@@ -560,9 +614,9 @@ void CPointsMap::determineMatching2D(
 			p.this_z = z[tentativ_this_idx];
 
 			p.other_idx = localIdx;
-			p.other_x = *x_other_it;
-			p.other_y = *y_other_it;
-			p.other_z = *z_other_it;
+			p.other_x = otherMap->x[localIdx];
+			p.other_y = otherMap->y[localIdx];
+			p.other_z = otherMap->z[localIdx];
 
 			p.errorSquareAfterTransformation = tentativ_err_sq;
 
@@ -573,7 +627,6 @@ void CPointsMap::determineMatching2D(
 			_sumSqrDist += p.errorSquareAfterTransformation;
 			_sumSqrCount++;
 		}
-
 	}  // For each local point
 
 	// Additional consistency filter: "onlyKeepTheClosest" up to now
@@ -1126,22 +1179,25 @@ void CPointsMap::determineMatching3D(
 	if (!nGlobalPoints || !nLocalPoints) return;
 
 	// Try to do matching only if the bounding boxes have some overlap:
-	// Transform all local points:
-	vector<float> x_locals(nLocalPoints), y_locals(nLocalPoints),
-		z_locals(nLocalPoints);
-
-	for (unsigned int localIdx = params.offset_other_map_points;
-		 localIdx < nLocalPoints;
-		 localIdx += params.decimation_other_map_points)
+	// Transform all the local points to be queried, into SoA buffers:
+	const size_t nQueries =
+		(nLocalPoints - params.offset_other_map_points +
+		 params.decimation_other_map_points - 1) /
+		params.decimation_other_map_points;
+	vector<float> x_locals(nQueries), y_locals(nQueries), z_locals(nQueries);
+
+	for (size_t k = 0; k < nQueries; k++)
 	{
+		const size_t localIdx = params.offset_other_map_points +
+								k * params.decimation_other_map_points;
 		float x_local, y_local, z_local;
 		otherMapPose.composePoint(
 			otherMap->x[localIdx], otherMap->y[localIdx], otherMap->z[localIdx],
 			x_local, y_local, z_local);
 
-		x_locals[localIdx] = x_local;
-		y_locals[localIdx] = y_local;
-		z_locals[localIdx] = z_local;
+		x_locals[k] = x_local;
+		y_locals[k] = y_local;
+		z_locals[k] = z_local;
 
 		// Find the bounding box:
 		local_x_min = min(local_x_min, x_local);
@@ -1165,65 +1221,62 @@ void CPointsMap::determineMatching3D(
 		local_y_min > global_y_max || local_y_max < global_y_min)
 		return;  // No need to compute: matching is ZERO.
 
-	// Loop for each point in local map:
-	// --------------------------------------------------
-	for (unsigned int localIdx = params.offset_other_map_points;
-		 localIdx < nLocalPoints;
-		 localIdx += params.decimation_other_map_points)
-	{
-		// For speed-up:
-		const float x_local = x_locals[localIdx];
-		const float y_local = y_locals[localIdx];
-		const float z_local = z_locals[localIdx];
-
-		{
-			// KD-TREE implementation
-			// Use a KD-tree to look for the nearnest neighbor of:
-			//   (x_local, y_local, z_local)
-			// In "this" (global/reference) points map.
+	// Search the closest point in "this" (global/reference) map for each
+	// local point, with batched KD-tree queries:
+	// --------------------------------------------------------------------
+	std::vector<size_t> closest_idxs(nQueries);
+	std::vector<float> closest_err_sqs(nQueries);
 
-			float tentativ_err_sq;
-			const unsigned int tentativ_this_idx = kdTreeClosestPoint3D(
-				x_local, y_local, z_local,  // Look closest to this guy
-				tentativ_err_sq  // save here the min. distance squared
-				);
+	matchingParallelFor(
+		params.numThreads, nQueries, [&](const size_t i0, const size_t i1) {
+			kdTreeClosestPoint3DBatch(
+				&x_locals[i0], &y_locals[i0], &z_locals[i0], i1 - i0,
+				&closest_idxs[i0], &closest_err_sqs[i0]);
+		});
 
-			// Compute max. allowed distance:
-			maxDistForCorrespondenceSquared = square(
-				params.maxAngularDistForCorrespondence *
-					params.angularDistPivotPoint.distanceTo(
-						TPoint3D(x_local, y_local, z_local)) +
-				params.maxDistForCorrespondence);
+	// Keep those below the distance threshold, in order:
+	// --------------------------------------------------
+	for (size_t k = 0; k < nQueries; k++)
+	{
+		const size_t localIdx = params.offset_other_map_points +
+								k * params.decimation_other_map_points;
+		const float tentativ_err_sq = closest_err_sqs[k];
+		const size_t tentativ_this_idx = closest_idxs[k];
 
-			// Distance below the threshold??
-			if (tentativ_err_sq < maxDistForCorrespondenceSquared)
-			{
-				// Save all the correspondences:
-				_correspondences.resize(_correspondences.size() + 1);
+		// Compute max. allowed distance:
+		maxDistForCorrespondenceSquared = square(
+			params.maxAngularDistForCorrespondence *
+				params.angularDistPivotPoint.distanceTo(
+					TPoint3D(x_locals[k], y_locals[k], z_locals[k])) +
+			params.maxDistForCorrespondence);
 
-				TMatchingPair& p = _correspondences.back();
+		// Distance below the threshold??
+		if (tentativ_err_sq < maxDistForCorrespondenceSquared)
+		{
+			// Save all the correspondences:
+			_correspondences.resize(_correspondences.size() + 1);
 
-				p.this_idx = tentativ_this_idx;
-				p.this_x = x[tentativ_this_idx];
-				p.this_y = y[tentativ_this_idx];
-				p.this_z = z[tentativ_this_idx];
+			TMatchingPair& p = _correspondences.back();
 
-				p.other_idx = localIdx;
-				p.other_x = otherMap->x[localIdx];
-				p.other_y = otherMap->y[localIdx];
-				p.other_z = otherMap->z[localIdx];
+			p.this_idx = tentativ_this_idx;
+			p.this_x = x[tentativ_this_idx];
+			p.this_y = y[tentativ_this_idx];
+			p.this_z = z[tentativ_this_idx];
 
-				p.errorSquareAfterTransformation = tentativ_err_sq;
+			p.other_idx = localIdx;
+			p.other_x = otherMap->x[localIdx];
+			p.other_y = otherMap->y[localIdx];
+			p.other_z = otherMap->z[localIdx];
 
-				// At least one:
-				nOtherMapPointsWithCorrespondence++;
+			p.errorSquareAfterTransformation = tentativ_err_sq;
 
-				// Accumulate the MSE:
-				_sumSqrDist += p.errorSquareAfterTransformation;
-				_sumSqrCount++;
-			}
+			// At least one:
+			nOtherMapPointsWithCorrespondence++;
 
-		}  // End of test_match
+			// Accumulate the MSE:
+			_sumSqrDist += p.errorSquareAfterTransformation;
+			_sumSqrCount++;
+		}
 	}  // For each local point
 
 	// Additional consistency filter: "onlyKeepTheClosest" up to now
@@ -1664,7 +1717,7 @@ void CPointsMap::addFrom(const CPointsMap& anotherMap)
 	// Also copy other data fields (color, ...)
 	addFrom_classSpecific(anotherMap, nThis);
 
-	mark_as_modified();
+	mark_as_appended();
 }
 
 /** Save the point cloud as a PCL PCD file, in either ASCII or binary format
@@ -1758,7 +1811,7 @@ void CPointsMap::insertAnotherMap(
 	// Also copy other data fields (color, ...)
 	addFrom_classSpecific(*otherMap, N_this);
 
-	mark_as_modified();
+	mark_as_appended();
 }
 
 /** Helper method for ::copyFrom() */
@@ -1812,7 +1865,6 @@ bool CPointsMap::internal_insertObservation(
 		/********************************************************************
 					OBSERVATION TYPE: CObservation2DRangeScan
 		 ********************************************************************/
-		mark_as_modified();
 
 		const CObservation2DRangeScan* o =
 			static_cast<const CObservation2DRangeScan*>(obs);
@@ -1904,7 +1956,6 @@ bool CPointsMap::internal_insertObservation(
 		/********************************************************************
 					OBSERVATION TYPE: CObservation3DRangeScan
 		 ********************************************************************/
-		mark_as_modified();
 
 		const CObservation3DRangeScan* o =
 			static_cast<const CObservation3DRangeScan*>(obs);
@@ -2015,7 +2066,6 @@ bool CPointsMap::internal_insertObservation(
 		/********************************************************************
 					OBSERVATION TYPE: CObservationVelodyneScan
 		 ********************************************************************/
-		mark_as_modified();
 
 		const CObservationVelodyneScan* o =
 			static_cast<const CObservationVelodyneScan*>(obs);
@@ -2065,8 +2115,6 @@ void CPointsMap::fuseWith(
 	TPoint3D a, b;
 	const CPose2D nullPose(0, 0, 0);
 
-	mark_as_modified();
-
 	// const size_t nThis  =     this->size();
 	const size_t nOther = otherMap->size();
 
@@ -2145,6 +2193,9 @@ void CPointsMap::fuseWith(
 			if (notFusedPoints) (*notFusedPoints).push_back(false);
 		}
 	}
+	// Existing points may have been fused: invalidate the KD-tree built for
+	// the correspondences above.
+	mark_as_modified();
 }
 
 void CPointsMap::loadFromVelodyneScan(
@@ -2157,7 +2208,10 @@ void CPointsMap::loadFromVelodyneScan(
 
 	if (scan.point_cloud.x.empty()) return;
 
-	this->mark_as_modified();
+	if (insertionOptions.addToExistingPointsMap)
+		this->mark_as_appended();
+	else
+		this->mark_as_modified();
 
 	// Insert vs. load and replace:
 	if (!insertionOptions.addToExistingPointsMap)
@@ -29,7 +29,10 @@ struct loadFromRangeImpl
 		using namespace mrpt::poses;
 		using mrpt::square;
 		using mrpt::DEG2RAD;
-		obj.mark_as_modified();
+		if (obj.insertionOptions.addToExistingPointsMap)
+			obj.mark_as_appended();
+		else
+			obj.mark_as_modified();
 
 		// The next may seem useless, but it's required in case the observation
 		// underwent a move or copy operator, which may change the reserved mem
@@ -381,7 +384,10 @@ struct loadFromRangeImpl
 	{
 		using namespace mrpt::poses;
 		using mrpt::square;
-		obj.mark_as_modified();
+		if (obj.insertionOptions.addToExistingPointsMap)
+			obj.mark_as_appended();
+		else
+			obj.mark_as_modified();
 
 		// If robot pose is supplied, compute sensor pose relative to it.
 		CPose3D sensorPose3D(UNINITIALIZED_POSE);
@@ -11,6 +11,8 @@
 #include <mrpt/maps/CWeightedPointsMap.h>
 #include <mrpt/maps/CColouredPointsMap.h>
 #include <mrpt/poses/CPoint2D.h>
+#include <mrpt/poses/CPose3D.h>
+#include <mrpt/random.h>
 #include <gtest/gtest.h>
 
 using namespace mrpt;
@@ -18,6 +20,7 @@ using namespace mrpt::maps;
 using namespace mrpt::obs;
 using namespace mrpt::poses;
 using namespace mrpt::math;
+using namespace mrpt::tfest;
 using namespace std;
 
 const size_t demo9_N = 9;
@@ -184,3 +187,95 @@ TEST(CColouredPointsMapTests, clipOutOfRange)
 {
 	do_test_clipOutOfRange<CColouredPointsMap>();
 }
+
+// Parallel and sequential search of correspondences must give the same
+// results, in the same order:
+static void do_test_determineMatching(const bool is3D)
+{
+	auto& rng = mrpt::random::getRandomGenerator();
+	rng.randomize(1234);
+	CSimplePointsMap globalMap, localMap;
+	for (int i = 0; i < 5000; i++)
+	{
+		globalMap.insertPoint(
+			rng.drawUniform(-10.f, 10.f), rng.drawUniform(-10.f, 10.f),
+			is3D ? rng.drawUniform(-1.f, 1.f) : 0.f);
+		localMap.insertPoint(
+			rng.drawUniform(-10.f, 10.f), rng.drawUniform(-10.f, 10.f),
+			is3D ? rng.drawUniform(-1.f, 1.f) : 0.f);
+	}
+	const CPose3D pose(0.2, -0.1, 0, DEG2RAD(5.0), 0, 0);
+
+	TMatchingParams params;
+	params.maxDistForCorrespondence = 0.1f;
+	params.maxAngularDistForCorrespondence = 0.005f;
+	for (size_t decim : {1, 3})
+	{
+		params.decimation_other_map_points = decim;
+		params.offset_other_map_points = decim - 1;
+
+		TMatchingPairList ref_corrs;
+		TMatchingExtraResults ref_extra;
+		for (unsigned int nThreads : {1, 3, 0})
+		{
+			params.numThreads = nThreads;
+			TMatchingPairList corrs;
+			TMatchingExtraResults extra;
+			if (is3D)
+				globalMap.determineMatching3D(
+					&localMap, pose, corrs, params, extra);
+			else
+				globalMap.determineMatching2D(
+					&localMap, CPose2D(pose), corrs, params, extra);
+
+			if (nThreads == 1)
+			{
+				ref_corrs = corrs;
+				ref_extra = extra;
+				EXPECT_GT(corrs.size(), 50u);
+				// Check against a brute-force search:
+				for (const auto& c : corrs)
+				{
+					EXPECT_EQ(c.other_idx % decim, decim - 1);
+					double gx, gy, gz;
+					pose.composePoint(
+						c.other_x, c.other_y, c.other_z, gx, gy, gz);
+					float best = std::numeric_limits<float>::max();
+					for (size_t i = 0; i < globalMap.size(); i++)
+					{
+						float px, py, pz;
+						globalMap.getPoint(i, px, py, pz);
+						best = std::min(
+							best, static_cast<float>(
+									  square(px - gx) + square(py - gy) +
+									  (is3D ? square(pz - gz) : 0)));
+					}
+					EXPECT_NEAR(c.errorSquareAfterTransformation, best, 1e-5);
+				}
+				continue;
+			}
+			ASSERT_EQ(corrs.size(), ref_corrs.size());
+			for (size_t i = 0; i < corrs.size(); i++)
+			{
+				EXPECT_EQ(corrs[i].this_idx, ref_corrs[i].this_idx);
+				EXPECT_EQ(corrs[i].other_idx, ref_corrs[i].other_idx);
+				EXPECT_EQ(
+					corrs[i].errorSquareAfterTransformation,
+					ref_corrs[i].errorSquareAfterTransformation);
+			}
+			EXPECT_EQ(extra.sumSqrDist, ref_extra.sumSqrDist);
+			EXPECT_EQ(
+				extra.correspondencesRatio, ref_extra.correspondencesRatio);
+		}
+	}
+}
+
+TEST(CSimplePointsMapTests, determineMatching2D_parallel)
+{
+	do_test_determineMatching(false);
+}
+
+TEST(CSimplePointsMapTests, determineMatching3D_parallel)
+{
+	do_test_determineMatching(true);
+}
@@ -73,11 +73,15 @@ void CSimplePointsMap::reserve(size_t newLength)
 //  and old contents are not changed.
 void CSimplePointsMap::resize(size_t newLength)
 {
+	const bool growing = newLength >= x.size();
 	this->reserve(newLength);  // to ensure 4N capacity
 	x.resize(newLength, 0);
 	y.resize(newLength, 0);
 	z.resize(newLength, 0);
-	mark_as_modified();
+	if (growing)
+		mark_as_appended();
+	else
+		mark_as_modified();
 }
 
 // Resizes all point buffers so they can hold the given number of points,
@@ -136,14 +140,12 @@ void CSimplePointsMap::serializeFrom(
 			uint32_t n;
 			in >> n;
 
+			// Bulk reads straight into the coordinates (a single copy from
+			// memory streams), then resize all other per-point fields:
+			in.ReadBufferFixEndiannessAssign(x, n);
+			in.ReadBufferFixEndiannessAssign(y, n);
+			in.ReadBufferFixEndiannessAssign(z, n);
 			this->resize(n);
-
-			if (n > 0)
-			{
-				in.ReadBufferFixEndianness(&x[0], n);
-				in.ReadBufferFixEndianness(&y[0], n);
-				in.ReadBufferFixEndianness(&z[0], n);
-			}
 			if (version >= 9)
 				in >> genericMapParams;
 			else
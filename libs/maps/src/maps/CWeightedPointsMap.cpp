@@ -192,16 +192,14 @@ void CWeightedPointsMap::serializeFrom(
 			uint32_t n;
 			in >> n;
 
+			// Bulk reads straight into the coordinates (a single copy from
+			// memory streams), then resize all other per-point fields:
+			in.ReadBufferFixEndiannessAssign(x, n);
+			in.ReadBufferFixEndiannessAssign(y, n);
+			in.ReadBufferFixEndiannessAssign(z, n);
+			in.ReadBufferFixEndiannessAssign(pointWeight, n);
 			this->resize(n);
 
-			if (n > 0)
-			{
-				in.ReadBufferFixEndianness(&x[0], n);
-				in.ReadBufferFixEndianness(&y[0], n);
-				in.ReadBufferFixEndianness(&z[0], n);
-				in.ReadBufferFixEndianness(&pointWeight[0], n);
-			}
-
 			if (version >= 1)
 			{
 				if (version >= 2)
@@ -11,7 +11,9 @@
 // nanoflann library:
 #include <nanoflann.hpp>
 #include <mrpt/math/lightweight_geom_data.h>
+#include <algorithm>  // sort
 #include <memory>  // unique_ptr
+#include <vector>
 
 namespace mrpt
 {
@@ -69,6 +71,18 @@ namespace math
  * different class instances for
  *  queries of each dimensionality, etc.
  *
+ *  By default, any change to the data points (see kdtree_mark_as_outdated())
+ * causes the whole KD-tree to be rebuilt on the next query. For data sets
+ * that grow by appending points (e.g. point maps built incrementally), the
+ * incremental mode (see TKDTreeSearchParams::incremental) keeps a forest of
+ * static KD-trees instead, so that only the newly appended points (see
+ * kdtree_mark_as_appended()) need to be indexed.
+ *
+ *  Once the KD-tree for a given dimensionality has been built, its query
+ * methods can be safely called from several threads at once. The (lazy)
+ * building itself is not thread-safe, so issue at least one query of each
+ * dimensionality from a single thread before querying concurrently.
+ *
  *  \sa See some of the derived classes for example implementations. See also
  * the documentation of nanoflann
  * \ingroup mrpt_math_grp
@@ -93,9 +107,20 @@ class KDTreeCapable
 	inline Derived& derived() { return *static_cast<Derived*>(this); }
 	struct TKDTreeSearchParams
 	{
-		TKDTreeSearchParams() : leaf_max_size(10) {}
+		TKDTreeSearchParams() : leaf_max_size(10), incremental(false) {}
 		/** Max points per leaf */
 		size_t leaf_max_size;
+		/** If enabled, the index is kept as a forest of static KD-trees, each
+		 * one covering a contiguous range of points (Bentley-Saxe
+		 * "logarithmic method"). Points appended to the data set (see
+		 * kdtree_mark_as_appended()) are indexed in a new tree, merged with
+		 * the existing trees not larger than it, for an amortized cost of
+		 * O(log N) per inserted point instead of a full O(N log N) rebuild.
+		 * Queries visit all trees (at most ~log2(N)), so they are somewhat
+		 * slower than with a single tree. The forest always uses the L2
+		 * distance of the derived class kdtree_distance(). (Default=false)
+		 */
+		bool incremental;
 	};
 
 	/** Parameters to tune the ANN searches */
@@ -135,11 +160,8 @@ class KDTreeCapable
 		nanoflann::KNNResultSet<num_t> resultSet(knn);
 		resultSet.init(&ret_index, &out_dist_sqr);
 
-		m_kdtree2d_data.query_point[0] = x0;
-		m_kdtree2d_data.query_point[1] = y0;
-		m_kdtree2d_data.index->findNeighbors(
-			resultSet, &m_kdtree2d_data.query_point[0],
-			nanoflann::SearchParams());
+		const num_t query_point[2] = {x0, y0};
+		kdtree_find_neighbors(m_kdtree2d_data, resultSet, query_point);
 
 		// Copy output to user vars:
 		out_x = derived().kdtree_get_pt(ret_index, 0);
@@ -163,11 +185,8 @@ class KDTreeCapable
 		nanoflann::KNNResultSet<num_t> resultSet(knn);
 		resultSet.init(&ret_index, &out_dist_sqr);
 
-		m_kdtree2d_data.query_point[0] = x0;
-		m_kdtree2d_data.query_point[1] = y0;
-		m_kdtree2d_data.index->findNeighbors(
-			resultSet, &m_kdtree2d_data.query_point[0],
-			nanoflann::SearchParams());
+		const num_t query_point[2] = {x0, y0};
+		kdtree_find_neighbors(m_kdtree2d_data, resultSet, query_point);
 
 		return ret_index;
 		MRPT_END
@@ -202,6 +221,37 @@ class KDTreeCapable
 			static_cast<float>(p0.x), static_cast<float>(p0.y));
 	}
 
+	/** Batched version of kdTreeClosestPoint2D(): for each of the `N` query
+	 * points `(xs[i*stride], ys[i*stride])`, stores the index of its closest
+	 * point in `out_idx[i]` and their square distance in `out_dist_sqr[i]`.
+	 * The KD-tree is checked (and rebuilt if needed) only once for all the
+	 * queries.
+	 *
+	 * Once the KD-tree is up to date (e.g. after a first query), this method
+	 * can be called concurrently from several threads, as long as the data
+	 * set is not modified meanwhile.
+	 * \sa kdTreeClosestPoint3DBatch
+	 */
+	inline void kdTreeClosestPoint2DBatch(
+		const float* xs, const float* ys, const size_t N, size_t* out_idx,
+		float* out_dist_sqr, const size_t stride = 1) const
+	{
+		MRPT_START
+		if (!N) return;
+		rebuild_kdTree_2D();  // First: Create the 2D KD-Tree if required
+		if (!m_kdtree2d_data.m_num_points)
+			THROW_EXCEPTION("There are no points in the KD-tree.");
+
+		nanoflann::KNNResultSet<num_t> resultSet(1);
+		for (size_t i = 0; i < N; i++)
+		{
+			resultSet.init(&out_idx[i], &out_dist_sqr[i]);
+			const num_t query_point[2] = {xs[i * stride], ys[i * stride]};
+			kdtree_find_neighbors(m_kdtree2d_data, resultSet, query_point);
+		}
+		MRPT_END
+	}
+
 	/** KD Tree-based search for the TWO closest point to some given 2D
 	  *coordinates.
 	  *  This method automatically build the "m_kdtree_data" structure when:
@@ -237,11 +287,8 @@ class KDTreeCapable
 		nanoflann::KNNResultSet<num_t> resultSet(knn);
 		resultSet.init(&ret_indexes[0], &ret_sqdist[0]);
 
-		m_kdtree2d_data.query_point[0] = x0;
-		m_kdtree2d_data.query_point[1] = y0;
-		m_kdtree2d_data.index->findNeighbors(
-			resultSet, &m_kdtree2d_data.query_point[0],
-			nanoflann::SearchParams());
+		const num_t query_point[2] = {x0, y0};
+		kdtree_find_neighbors(m_kdtree2d_data, resultSet, query_point);
 
 		// Copy output to user vars:
 		out_x1 = derived().kdtree_get_pt(ret_indexes[0], 0);
@@ -306,11 +353,8 @@ class KDTreeCapable
 		nanoflann::KNNResultSet<num_t> resultSet(knn);
 		resultSet.init(&ret_indexes[0], &out_dist_sqr[0]);
 
-		m_kdtree2d_data.query_point[0] = x0;
-		m_kdtree2d_data.query_point[1] = y0;
-		m_kdtree2d_data.index->findNeighbors(
-			resultSet, &m_kdtree2d_data.query_point[0],
-			nanoflann::SearchParams());
+		const num_t query_point[2] = {x0, y0};
+		kdtree_find_neighbors(m_kdtree2d_data, resultSet, query_point);
 
 		for (size_t i = 0; i < knn; i++)
 		{
@@ -368,11 +412,8 @@ class KDTreeCapable
 		nanoflann::KNNResultSet<num_t> resultSet(knn);
 		resultSet.init(&out_idx[0], &out_dist_sqr[0]);
 
-		m_kdtree2d_data.query_point[0] = x0;
-		m_kdtree2d_data.query_point[1] = y0;
-		m_kdtree2d_data.index->findNeighbors(
-			resultSet, &m_kdtree2d_data.query_point[0],
-			nanoflann::SearchParams());
+		const num_t query_point[2] = {x0, y0};
+		kdtree_find_neighbors(m_kdtree2d_data, resultSet, query_point);
 		MRPT_END
 	}
 
@@ -418,12 +459,8 @@ class KDTreeCapable
 		nanoflann::KNNResultSet<num_t> resultSet(knn);
 		resultSet.init(&ret_index, &out_dist_sqr);
 
-		m_kdtree3d_data.query_point[0] = x0;
-		m_kdtree3d_data.query_point[1] = y0;
-		m_kdtree3d_data.query_point[2] = z0;
-		m_kdtree3d_data.index->findNeighbors(
-			resultSet, &m_kdtree3d_data.query_point[0],
-			nanoflann::SearchParams());
+		const num_t query_point[3] = {x0, y0, z0};
+		kdtree_find_neighbors(m_kdtree3d_data, resultSet, query_point);
 
 		// Copy output to user vars:
 		out_x = derived().kdtree_get_pt(ret_index, 0);
@@ -448,12 +485,8 @@ class KDTreeCapable
 		nanoflann::KNNResultSet<num_t> resultSet(knn);
 		resultSet.init(&ret_index, &out_dist_sqr);
 
-		m_kdtree3d_data.query_point[0] = x0;
-		m_kdtree3d_data.query_point[1] = y0;
-		m_kdtree3d_data.query_point[2] = z0;
-		m_kdtree3d_data.index->findNeighbors(
-			resultSet, &m_kdtree3d_data.query_point[0],
-			nanoflann::SearchParams());
+		const num_t query_point[3] = {x0, y0, z0};
+		kdtree_find_neighbors(m_kdtree3d_data, resultSet, query_point);
 
 		return ret_index;
 		MRPT_END
@@ -473,6 +506,37 @@ class KDTreeCapable
 		return res;
 	}
 
+	/** Batched version of kdTreeClosestPoint3D(): for each of the `N` query
+	 * points `(xs[i], ys[i], zs[i])`, stores the index of its closest point
+	 * in `out_idx[i]` and their square distance in `out_dist_sqr[i]`. The
+	 * KD-tree is checked (and rebuilt if needed) only once for all the
+	 * queries.
+	 *
+	 * Once the KD-tree is up to date (e.g. after a first query), this method
+	 * can be called concurrently from several threads, as long as the data
+	 * set is not modified meanwhile.
+	 * \sa kdTreeClosestPoint2DBatch
+	 */
+	inline void kdTreeClosestPoint3DBatch(
+		const float* xs, const float* ys, const float* zs, const size_t N,
+		size_t* out_idx, float* out_dist_sqr) const
+	{
+		MRPT_START
+		if (!N) return;
+		rebuild_kdTree_3D();  // First: Create the 3D KD-Tree if required
+		if (!m_kdtree3d_data.m_num_points)
+			THROW_EXCEPTION("There are no points in the KD-tree.");
+
+		nanoflann::KNNResultSet<num_t> resultSet(1);
+		for (size_t i = 0; i < N; i++)
+		{
+			resultSet.init(&out_idx[i], &out_dist_sqr[i]);
+			const num_t query_point[3] = {xs[i], ys[i], zs[i]};
+			kdtree_find_neighbors(m_kdtree3d_data, resultSet, query_point);
+		}
+		MRPT_END
+	}
+
 	/** KD Tree-based search for the N closest points to some given 3D
 	  *coordinates.
 	  *  This method automatically build the "m_kdtree_data" structure when:
@@ -514,12 +578,8 @@ class KDTreeCapable
 		nanoflann::KNNResultSet<num_t> resultSet(knn);
 		resultSet.init(&ret_indexes[0], &out_dist_sqr[0]);
 
-		m_kdtree3d_data.query_point[0] = x0;
-		m_kdtree3d_data.query_point[1] = y0;
-		m_kdtree3d_data.query_point[2] = z0;
-		m_kdtree3d_data.index->findNeighbors(
-			resultSet, &m_kdtree3d_data.query_point[0],
-			nanoflann::SearchParams());
+		const num_t query_point[3] = {x0, y0, z0};
+		kdtree_find_neighbors(m_kdtree3d_data, resultSet, query_point);
 
 		for (size_t i = 0; i < knn; i++)
 		{
@@ -572,12 +632,8 @@ class KDTreeCapable
 		nanoflann::KNNResultSet<num_t> resultSet(knn);
 		resultSet.init(&out_idx[0], &out_dist_sqr[0]);
 
-		m_kdtree3d_data.query_point[0] = x0;
-		m_kdtree3d_data.query_point[1] = y0;
-		m_kdtree3d_data.query_point[2] = z0;
-		m_kdtree3d_data.index->findNeighbors(
-			resultSet, &m_kdtree3d_data.query_point[0],
-			nanoflann::SearchParams());
+		const num_t query_point[3] = {x0, y0, z0};
+		kdtree_find_neighbors(m_kdtree3d_data, resultSet, query_point);
 
 		for (size_t i = 0; i < knn; i++)
 		{
@@ -633,9 +689,8 @@ class KDTreeCapable
 		if (m_kdtree3d_data.m_num_points != 0)
 		{
 			const num_t xyz[3] = {x0, y0, z0};
-			m_kdtree3d_data.index->radiusSearch(
-				&xyz[0], maxRadiusSqr, out_indices_dist,
-				nanoflann::SearchParams());
+			kdtree_radius_search(
+				m_kdtree3d_data, xyz, maxRadiusSqr, out_indices_dist);
 		}
 		return out_indices_dist.size();
 		MRPT_END
@@ -667,9 +722,8 @@ class KDTreeCapable
 		if (m_kdtree2d_data.m_num_points != 0)
 		{
 			const num_t xyz[2] = {x0, y0};
-			m_kdtree2d_data.index->radiusSearch(
-				&xyz[0], maxRadiusSqr, out_indices_dist,
-				nanoflann::SearchParams());
+			kdtree_radius_search(
+				m_kdtree2d_data, xyz, maxRadiusSqr, out_indices_dist);
 		}
 		return out_indices_dist.size();
 		MRPT_END
@@ -706,12 +760,8 @@ class KDTreeCapable
 		nanoflann::KNNResultSet<num_t> resultSet(knn);
 		resultSet.init(&out_idx[0], &out_dist_sqr[0]);
 
-		m_kdtree3d_data.query_point[0] = x0;
-		m_kdtree3d_data.query_point[1] = y0;
-		m_kdtree3d_data.query_point[2] = z0;
-		m_kdtree3d_data.index->findNeighbors(
-			resultSet, &m_kdtree3d_data.query_point[0],
-			nanoflann::SearchParams());
+		const num_t query_point[3] = {x0, y0, z0};
+		kdtree_find_neighbors(m_kdtree3d_data, resultSet, query_point);
 		MRPT_END
 	}
 
@@ -733,6 +783,16 @@ class KDTreeCapable
 		m_kdtree_is_uptodate = false;
 	}
 
+	/** To be called by child classes when new data points have been appended
+	 * at the end, with all the previous points keeping their indices and
+	 * values. In the incremental mode only the new points will be indexed in
+	 * the next query; otherwise, this is equivalent to
+	 * kdtree_mark_as_outdated(). */
+	inline void kdtree_mark_as_appended() const
+	{
+		if (!kdtree_search_params.incremental) m_kdtree_is_uptodate = false;
+	}
+
    private:
 	/** Internal structure with the KD-tree representation (mainly used to avoid
 	 * copying pointers with the = operator) */
@@ -754,14 +814,54 @@ class KDTreeCapable
 		}
 
 		/** Free memory (if allocated)  */
-		inline void clear() noexcept { index.reset(); }
+		inline void clear() noexcept
+		{
+			index.reset();
+			forest.clear();
+			m_num_points = 0;
+		}
 		typedef nanoflann::KDTreeSingleIndexAdaptor<metric_t, Derived, _DIM>
 			kdtree_index_t;
 
+		/** Dataset adaptor for the points [offset, offset+count) of the
+		 * derived class, indexed by one tree of the incremental forest */
+		struct TRangeAdaptor
+		{
+			const Derived* data;
+			size_t offset, count;
+
+			inline size_t kdtree_get_point_count() const { return count; }
+			inline num_t kdtree_get_pt(const size_t idx, int dim) const
+			{
+				return data->kdtree_get_pt(offset + idx, dim);
+			}
+			inline num_t kdtree_distance(
+				const num_t* p1, const size_t idx_p2, size_t size) const
+			{
+				return data->kdtree_distance(p1, offset + idx_p2, size);
+			}
+			template <class BBOX>
+			bool kdtree_get_bbox(BBOX&) const
+			{
+				return false;
+			}
+		};
+		typedef nanoflann::KDTreeSingleIndexAdaptor<
+			nanoflann::L2_Simple_Adaptor<num_t, TRangeAdaptor>, TRangeAdaptor,
+			_DIM>
+			subtree_index_t;
+		struct TSubTree
+		{
+			TRangeAdaptor dataset;
+			std::unique_ptr<subtree_index_t> index;
+		};
+
 		/** nullptr or the up-to-date index */
 		std::unique_ptr<kdtree_index_t> index;
+		/** Incremental mode: trees covering consecutive ranges of points, in
+		 * order of decreasing size. */
+		std::vector<std::unique_ptr<TSubTree>> forest;
 
-		std::vector<num_t> query_point;
 		/** Dimensionality. typ: 2,3 */
 		size_t m_dim = _DIM;
 		size_t m_num_points = 0;
@@ -773,6 +873,110 @@ class KDTreeCapable
 	/** whether the KD tree needs to be rebuilt or not. */
 	mutable bool m_kdtree_is_uptodate;
 
+	/** Wraps a nanoflann result set to convert the indices reported by one
+	 * tree of the incremental forest into indices of the whole data set */
+	template <class RESULTSET>
+	struct TOffsetResultSet
+	{
+		RESULTSET& result;
+		const size_t offset;
+
+		inline void addPoint(num_t dist, size_t index)
+		{
+			result.addPoint(dist, index + offset);
+		}
+		inline num_t worstDist() const { return result.worstDist(); }
+		inline bool full() const { return result.full(); }
+	};
+
+	/// Runs a nanoflann query on either the single KD-tree or all the trees
+	/// of the incremental forest.
+	template <int _DIM, class RESULTSET>
+	void kdtree_find_neighbors(
+		const TKDTreeDataHolder<_DIM>& data, RESULTSET& resultSet,
+		const num_t* query_point) const
+	{
+		if (data.index)
+		{
+			data.index->findNeighbors(
+				resultSet, query_point, nanoflann::SearchParams());
+			return;
+		}
+		for (const auto& tree : data.forest)
+		{
+			TOffsetResultSet<RESULTSET> treeResultSet{resultSet,
+													  tree->dataset.offset};
+			tree->index->findNeighbors(
+				treeResultSet, query_point, nanoflann::SearchParams());
+		}
+	}
+
+	/// Radius search on either the single KD-tree or all the trees of the
+	/// incremental forest. Results are sorted by ascending distance.
+	template <int _DIM>
+	void kdtree_radius_search(
+		const TKDTreeDataHolder<_DIM>& data, const num_t* query_point,
+		const num_t maxRadiusSqr,
+		std::vector<std::pair<size_t, num_t>>& out_indices_dist) const
+	{
+		if (data.index)
+		{
+			data.index->radiusSearch(
+				query_point, maxRadiusSqr, out_indices_dist,
+				nanoflann::SearchParams());
+			return;
+		}
+		nanoflann::RadiusResultSet<num_t, size_t> resultSet(
+			maxRadiusSqr, out_indices_dist);
+		kdtree_find_neighbors(data, resultSet, query_point);
+		std::sort(
+			out_indices_dist.begin(), out_indices_dist.end(),
+			nanoflann::IndexDist_Sorter());
+	}
+
+	/// Incremental mode: indexes the points appended since the last call in
+	/// a new tree, merged with all the trees not larger than it, so the
+	/// forest always has O(log N) trees and each point is re-indexed
+	/// O(log N) times along the life of the data set.
+	template <int _DIM>
+	void update_kdTree_forest(TKDTreeDataHolder<_DIM>& data) const
+	{
+		typedef typename TKDTreeDataHolder<_DIM>::TSubTree subtree_t;
+		typedef typename TKDTreeDataHolder<_DIM>::subtree_index_t index_t;
+
+		const size_t N = derived().kdtree_get_point_count();
+		// A single tree from the non-incremental mode, or removed points:
+		if (data.index || N < data.m_num_points) data.clear();
+
+		// Nothing is written if the forest is up to date, so concurrent
+		// queries are safe:
+		if (N > data.m_num_points)
+		{
+			data.m_dim = _DIM;
+			size_t first = data.m_num_points, count = N - data.m_num_points;
+			while (!data.forest.empty() &&
+				   data.forest.back()->dataset.count <= count)
+			{
+				first = data.forest.back()->dataset.offset;
+				count += data.forest.back()->dataset.count;
+				data.forest.pop_back();
+			}
+			std::unique_ptr<subtree_t> tree(new subtree_t);
+			tree->dataset.data = &derived();
+			tree->dataset.offset = first;
+			tree->dataset.count = count;
+			tree->index.reset(
+				new index_t(
+					_DIM, tree->dataset,
+					nanoflann::KDTreeSingleIndexAdaptorParams(
+						kdtree_search_params.leaf_max_size)));
+			tree->index->buildIndex();
+			data.forest.push_back(std::move(tree));
+			data.m_num_points = N;
+		}
+		if (!m_kdtree_is_uptodate) m_kdtree_is_uptodate = true;
+	}
+
 	/// Rebuild, if needed the KD-tree for 2D (nDims=2), 3D (nDims=3), ...
 	/// asking the child class for the data points.
 	void rebuild_kdTree_2D() const
@@ -786,7 +990,15 @@ class KDTreeCapable
 			m_kdtreeNd_data.clear();
 		}
 
-		if (!m_kdtree2d_data.index)
+		if (kdtree_search_params.incremental)
+		{
+			update_kdTree_forest(m_kdtree2d_data);
+			return;
+		}
+
+		if (!m_kdtree2d_data.index ||
+			m_kdtree2d_data.m_num_points !=
+				derived().kdtree_get_point_count())
 		{
 			// Erase previous tree:
 			m_kdtree2d_data.clear();
@@ -794,7 +1006,6 @@ class KDTreeCapable
 			const size_t N = derived().kdtree_get_point_count();
 			m_kdtree2d_data.m_num_points = N;
 			m_kdtree2d_data.m_dim = 2;
-			m_kdtree2d_data.query_point.resize(2);
 			if (N)
 			{
 				m_kdtree2d_data.index.reset(
@@ -820,7 +1031,15 @@ class KDTreeCapable
 			m_kdtreeNd_data.clear();
 		}
 
-		if (!m_kdtree3d_data.index)
+		if (kdtree_search_params.incremental)
+		{
+			update_kdTree_forest(m_kdtree3d_data);
+			return;
+		}
+
+		if (!m_kdtree3d_data.index ||
+			m_kdtree3d_data.m_num_points !=
+				derived().kdtree_get_point_count())
 		{
 			// Erase previous tree:
 			m_kdtree3d_data.clear();
@@ -828,7 +1047,6 @@ class KDTreeCapable
 			const size_t N = derived().kdtree_get_point_count();
 			m_kdtree3d_data.m_num_points = N;
 			m_kdtree3d_data.m_dim = 3;
-			m_kdtree3d_data.query_point.resize(3);
 			if (N)
 			{
 				m_kdtree3d_data.index.reset(
@@ -26,9 +26,9 @@ void CMatrix::serializeTo(mrpt::serialization::CArchive& out) const
 	// First, write the number of rows and columns:
 	out << (uint32_t)rows() << (uint32_t)cols();
 
+	// RowMajor storage: the whole matrix is written as a single block.
 	if (rows() > 0 && cols() > 0)
-		for (Index i = 0; i < rows(); i++)
-			out.WriteBufferFixEndianness<Scalar>(&coeff(i, 0), cols());
+		out.WriteBufferFixEndianness<Scalar>(data(), size());
 }
 
 void CMatrix::serializeFrom(mrpt::serialization::CArchive& in, uint8_t version)
@@ -42,11 +42,12 @@ void CMatrix::serializeFrom(mrpt::serialization::CArchive& in, uint8_t version)
 			// First, write the number of rows and columns:
 			in >> nRows >> nCols;
 
-			setSize(nRows, nCols);
+			// Eigen's resize() does not zero-fill the new elements, which
+			// are all overwritten with a single bulk read:
+			resize(nRows, nCols);
 
 			if (nRows > 0 && nCols > 0)
-				for (Index i = 0; i < rows(); i++)
-					in.ReadBufferFixEndianness<Scalar>(&coeffRef(i, 0), nCols);
+				in.ReadBufferFixEndianness<Scalar>(data(), size());
 		}
 		break;
 		default:
@@ -16,4 +16,130 @@ using namespace mrpt::math;
 using namespace mrpt::random;
 using namespace std;
 
-TEST(KDTreeCapable, test1) { MRPT_TODO("Write me!"); }
+namespace
+{
+// A minimal point cloud that grows by appending points:
+class MyPointCloud : public KDTreeCapable<MyPointCloud>
+{
+   public:
+	std::vector<float> xs, ys, zs;
+
+	void append(float x, float y, float z)
+	{
+		xs.push_back(x);
+		ys.push_back(y);
+		zs.push_back(z);
+		kdtree_mark_as_appended();
+	}
+	void setPoint(size_t i, float x, float y, float z)
+	{
+		xs[i] = x;
+		ys[i] = y;
+		zs[i] = z;
+		kdtree_mark_as_outdated();
+	}
+
+	inline size_t kdtree_get_point_count() const { return xs.size(); }
+	inline float kdtree_get_pt(const size_t idx, int dim) const
+	{
+		return dim == 0 ? xs[idx] : (dim == 1 ? ys[idx] : zs[idx]);
+	}
+	inline float kdtree_distance(
+		const float* p1, const size_t idx_p2, size_t size) const
+	{
+		float d = 0;
+		for (size_t k = 0; k < size; k++)
+			d += square(p1[k] - kdtree_get_pt(idx_p2, k));
+		return d;
+	}
+	template <class BBOX>
+	bool kdtree_get_bbox(BBOX&) const
+	{
+		return false;
+	}
+
+	// Brute-force reference:
+	float closestDistSqr(const float* p, size_t dims) const
+	{
+		float best = std::numeric_limits<float>::max();
+		for (size_t i = 0; i < xs.size(); i++)
+			best = std::min(best, kdtree_distance(p, i, dims));
+		return best;
+	}
+	size_t countInRadius(const float* p, size_t dims, float r2) const
+	{
+		size_t n = 0;
+		for (size_t i = 0; i < xs.size(); i++)
+			if (kdtree_distance(p, i, dims) < r2) n++;
+		return n;
+	}
+};
+
+void checkQueries(const MyPointCloud& pc, const std::string& ctx)
+{
+	auto& rng = getRandomGenerator();
+	for (int q = 0; q < 20; q++)
+	{
+		const float p[3] = {static_cast<float>(rng.drawUniform(-12, 12)),
+							static_cast<float>(rng.drawUniform(-12, 12)),
+							static_cast<float>(rng.drawUniform(-12, 12))};
+
+		float dist2D, dist3D;
+		const size_t idx2D = pc.kdTreeClosestPoint2D(p[0], p[1], dist2D);
+		EXPECT_FLOAT_EQ(dist2D, pc.closestDistSqr(p, 2)) << ctx;
+		EXPECT_FLOAT_EQ(dist2D, pc.kdtree_distance(p, idx2D, 2)) << ctx;
+
+		const size_t idx3D =
+			pc.kdTreeClosestPoint3D(p[0], p[1], p[2], dist3D);
+		EXPECT_FLOAT_EQ(dist3D, pc.closestDistSqr(p, 3)) << ctx;
+		EXPECT_FLOAT_EQ(dist3D, pc.kdtree_distance(p, idx3D, 3)) << ctx;
+
+		std::vector<size_t> idxs;
+		std::vector<float> dists;
+		pc.kdTreeNClosestPoint3DIdx(p[0], p[1], p[2], 4, idxs, dists);
+		ASSERT_EQ(idxs.size(), 4u) << ctx;
+		EXPECT_FLOAT_EQ(dists[0], dist3D) << ctx;
+		for (size_t k = 1; k < dists.size(); k++)
+			EXPECT_LE(dists[k - 1], dists[k]) << ctx;
+
+		const float r2 = 4.0f;
+		std::vector<std::pair<size_t, float>> found;
+		pc.kdTreeRadiusSearch3D(p[0], p[1], p[2], r2, found);
+		EXPECT_EQ(found.size(), pc.countInRadius(p, 3, r2)) << ctx;
+		for (size_t k = 1; k < found.size(); k++)
+			EXPECT_LE(found[k - 1].second, found[k].second) << ctx;
+	}
+}
+
+void runGrowingCloud(const bool incremental)
+{
+	getRandomGenerator().randomize(123);
+	auto& rng = getRandomGenerator();
+
+	MyPointCloud pc;
+	pc.kdtree_search_params.incremental = incremental;
+
+	for (int batch = 0; batch < 40; batch++)
+	{
+		const size_t n = 1 + rng.drawUniform32bit() % 60;
+		for (size_t i = 0; i < n; i++)
+			pc.append(
+				rng.drawUniform(-10, 10), rng.drawUniform(-10, 10),
+				rng.drawUniform(-10, 10));
+
+		// Once in a while, move an existing point:
+		if (batch % 7 == 6)
+			pc.setPoint(
+				rng.drawUniform32bit() % pc.xs.size(), rng.drawUniform(-10, 10),
+				rng.drawUniform(-10, 10), rng.drawUniform(-10, 10));
+
+		checkQueries(
+			pc, mrpt::format(
+					"incremental=%i batch=%i N=%u", incremental ? 1 : 0, batch,
+					static_cast<unsigned>(pc.xs.size())));
+	}
+}
+}  // namespace
+
+TEST(KDTreeCapable, growingCloud) { runGrowingCloud(false); }
+TEST(KDTreeCapable, growingCloudIncremental) { runGrowingCloud(true); }
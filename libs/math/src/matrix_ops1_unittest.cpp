@@ -12,6 +12,7 @@
 // compiling in small systems.
 
 #include <mrpt/math/CMatrixFixedNumeric.h>
+#include <mrpt/math/CMatrix.h>
 #include <mrpt/math/CMatrixD.h>
 #include <mrpt/math/matrix_serialization.h>  // serialization of matrices
 //#include <mrpt/math/ops_matrices.h>
@@ -87,6 +88,29 @@ TEST(Matrices, SerializeCMatrixD)
 	}
 }
 
+TEST(Matrices, SerializeCMatrix)
+{
+	CMatrix A(7, 5);
+	for (int r = 0; r < 7; r++)
+		for (int c = 0; c < 5; c++) A(r, c) = r * 10.0f + c;
+
+	mrpt::io::CMemoryStream membuf;
+	auto arch = mrpt::serialization::archiveFrom(membuf);
+	arch << A;
+
+	// Deserialize into matrices of other sizes:
+	for (int n : {0, 3, 20})
+	{
+		CMatrix B(n, n);
+		membuf.Seek(0);
+		arch >> B;
+		ASSERT_EQ(B.rows(), 7);
+		ASSERT_EQ(B.cols(), 5);
+		EXPECT_EQ(B(6, 4), 64.0f);
+		EXPECT_NEAR(0, (B - A).array().abs().sum(), 1e-9);
+	}
+}
+
 TEST(Matrices, EigenVal2x2dyn)
 {
 	const double dat_C1[] = {14.6271, 5.8133, 5.8133, 16.8805};
@@ -11,6 +11,7 @@
 #include <vector>
 #include <map>
 #include <cstdint>
+#include <cstddef>
 #include <mrpt/opengl/opengl_frwds.h>
 #include <mrpt/serialization/serialization_frwds.h>
 
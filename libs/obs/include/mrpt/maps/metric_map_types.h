@@ -42,6 +42,11 @@ struct TMatchingParams
 	/** The point used to calculate angular distances: e.g. the coordinates of
 	 * the sensor for a 2D laser scanner. */
 	mrpt::math::TPoint3D angularDistPivotPoint;
+	/** (Default=1) Number of threads for the search of correspondences
+	 * between points maps: 1 means a plain loop in the calling thread, 0
+	 * one thread per core. Results are identical for any number of threads.
+	 */
+	unsigned int numThreads;
 
 	/** Ctor: default values */
 	TMatchingParams()
@@ -51,7 +56,8 @@ struct TMatchingParams
 		  onlyUniqueRobust(false),
 		  decimation_other_map_points(1),
 		  offset_other_map_points(0),
-		  angularDistPivotPoint(0, 0, 0)
+		  angularDistPivotPoint(0, 0, 0),
+		  numThreads(1)
 	{
 	}
 };
@@ -254,6 +254,9 @@ class CObservationVelodyneScan : public CObservation
 		bool generatePerPointTimestamp{false};
 		/** (Default:false) If `true`, populate the vector azimuth */
 		bool generatePerPointAzimuth{false};
+		/** (Default:1) Number of threads used to decode the data packets in
+		 * parallel (0: one per CPU core). The output does not depend on it. */
+		unsigned int numThreads{1};
 	};
 
 	/** Generates the point cloud into the point cloud data fields in \a
@@ -273,6 +276,12 @@ class CObservationVelodyneScan : public CObservation
 		const TGeneratePointCloudParameters& params =
 			TGeneratePointCloudParameters());
 
+	/** Like generatePointCloud(), but leaving the point cloud in \a dest
+	 * instead of CObservationVelodyneScan::point_cloud. Points are decoded
+	 * directly into its (reused) x,y,z,... arrays. */
+	void generatePointCloud(
+		TPointCloud& dest, const TGeneratePointCloudParameters& params) const;
+
 	/** Results for generatePointCloudAlongSE3Trajectory() */
 	struct TGeneratePointCloudSE3Results
 	{
@@ -14,6 +14,7 @@
 #include <mrpt/obs/CActionCollection.h>
 #include <mrpt/obs/CObservationComment.h>
 #include <mrpt/config/CConfigFileMemory.h>
+#include <memory>
 
 namespace mrpt
 {
@@ -60,6 +61,8 @@ typedef std::multimap<mrpt::system::TTimeStamp, CObservation::Ptr>
  * \note The format #2 is supported since MRPT version 0.6.0.
  * \note There is a static helper method "detectImagesDirectory" for localizing
  *the external images directory of a rawlog.
+ * \note Large datasets can be opened without loading them into memory with
+ *loadFromRawLogFileLazy(), see CRawlogIndex.
  *
  * \sa CSensoryFrame, CPose2D, <a href="http://www.mrpt.org/Rawlog_Format">
  *RawLog file format</a>.
@@ -71,8 +74,23 @@ class CRawlog : public mrpt::serialization::CSerializable
 
    private:
 	typedef std::vector<mrpt::serialization::CSerializable::Ptr> TListObjects;
-	/** The list where the objects really are in. */
-	TListObjects m_seqOfActObs;
+	/** The list where the objects really are in. Mutable since, in lazy mode,
+	 * it is filled upon the first access through STL-like iterators. */
+	mutable TListObjects m_seqOfActObs;
+
+	/** Lazy mode: rawlog file, index and cache of loaded entries. Shared
+	 * among copies of this object, since they are read-only. */
+	struct TLazyBackend;
+	mutable std::shared_ptr<TLazyBackend> m_lazy;
+	/** In lazy mode, loads all entries into m_seqOfActObs and leaves lazy
+	 * mode */
+	void loadAllLazyEntries() const;
+	inline void ensureNotLazy() const
+	{
+		if (m_lazy) loadAllLazyEntries();
+	}
+	/** The i'th object, loading it if needed (no bound checks) */
+	mrpt::serialization::CSerializable::Ptr getEntry(size_t index) const;
 
 	/** Comments of the rawlog. */
 	CObservationComment m_commentTexts;
@@ -167,6 +185,41 @@ class CRawlog : public mrpt::serialization::CSerializable
 	bool loadFromRawLogFile(
 		const std::string& fileName, bool non_obs_objects_are_legal = false);
 
+	/** Opens a rawlog file for random access without loading it into
+	 * memory: entries are deserialized from the file upon access (e.g.
+	 * getAsObservation()), and the last `setLazyCacheSize()` ones are kept in
+	 * memory.
+	 *
+	 * This requires a sidecar index, see CRawlogIndex. If \a indexFile is
+	 * empty, CRawlogIndex::defaultIndexFileName() is used. If the index does
+	 * not exist or is outdated, it is (re)built if \a buildIndexIfNeeded is
+	 * true, which requires reading the whole file once.
+	 *
+	 * The rawlog is used as a normal one, transparently; methods which modify
+	 * the sequence (add*, remove, erase) or use STL-like iterators (begin(),
+	 * end()) load all entries into memory first.
+	 * Changes to the objects retrieved in lazy mode are only kept while they
+	 * are in the cache (or referenced elsewhere).
+	 *
+	 * Random access is only efficient in uncompressed rawlogs, since
+	 * gz-compressed streams can only be read forward: seeking backwards
+	 * decompresses again from the beginning of the file.
+	 *
+	 * \return false upon error reading the file or building the index.
+	 * \sa loadFromRawLogFile, isLazy
+	 */
+	bool loadFromRawLogFileLazy(
+		const std::string& fileName, bool non_obs_objects_are_legal = false,
+		bool buildIndexIfNeeded = true, const std::string& indexFile = {});
+
+	/** Returns true if the rawlog was open with loadFromRawLogFileLazy() and
+	 * its entries are loaded on demand */
+	bool isLazy() const { return m_lazy != nullptr; }
+
+	/** In lazy mode, the maximum number of deserialized entries to keep in
+	 * memory (Default=256) */
+	void setLazyCacheSize(size_t maxEntries);
+
 	/** Saves the contents to a rawlog-file, compatible with RawlogViewer (As
 	 * the sequence of internal objects).
 	  *  The file is saved with gz-commpressed if MRPT has gz-streams.
@@ -344,12 +397,29 @@ class CRawlog : public mrpt::serialization::CSerializable
 		}
 	};
 
-	const_iterator begin() const { return m_seqOfActObs.begin(); }
-	iterator begin() { return m_seqOfActObs.begin(); }
-	const_iterator end() const { return m_seqOfActObs.end(); }
-	iterator end() { return m_seqOfActObs.end(); }
+	const_iterator begin() const
+	{
+		ensureNotLazy();
+		return m_seqOfActObs.cbegin();
+	}
+	iterator begin()
+	{
+		ensureNotLazy();
+		return m_seqOfActObs.begin();
+	}
+	const_iterator end() const
+	{
+		ensureNotLazy();
+		return m_seqOfActObs.cend();
+	}
+	iterator end()
+	{
+		ensureNotLazy();
+		return m_seqOfActObs.end();
+	}
 	iterator erase(const iterator& it)
 	{
+		ensureNotLazy();
 		return iterator::erase(m_seqOfActObs, it);
 	}
 
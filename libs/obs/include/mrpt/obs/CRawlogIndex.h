@@ -0,0 +1,173 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/io/CMemoryMappedFile.h>
+#include <mrpt/system/datetime.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace mrpt
+{
+namespace obs
+{
+/** A sidecar index of a rawlog file, which allows random access to its
+ * entries without deserializing the whole dataset.
+ *
+ * The index is built once with CRawlogIndex::build() (or `rawlog-edit
+ * --build-index`), which reads the rawlog sequentially and saves, for each
+ * top-level object in the file: its offset in the (uncompressed) stream, its
+ * timestamp, class name and sensor label. By default it is saved next to the
+ * rawlog, as `<rawlog_file>.idx` (see defaultIndexFileName()).
+ *
+ * Opening an index memory-maps it, so it takes constant time regardless of the
+ * dataset size, and gives:
+ *  - O(1) access to the metadata of entry `i`, and
+ *  - timestamp searches in O(log N), through an array of entries sorted by
+ *    timestamp which is also stored in the file.
+ *
+ * CRawlog::loadFromRawLogFileLazy() uses this index to deserialize only the
+ * entries actually accessed. Note that gz-compressed streams can only be
+ * efficiently read forwards: for fast random access to arbitrary entries,
+ * use uncompressed rawlogs.
+ *
+ * File format (little endian):
+ *  - Header (TFileHeader, 96 bytes).
+ *  - `numEntries` TEntry records (32 bytes each).
+ *  - `numSorted` uint64_t entry indices, sorted by ascending timestamp
+ *    (entries with invalid timestamps are not included).
+ *  - String table: `numStrings` strings, each as a uint32_t length followed
+ *    by its characters.
+ *
+ * \sa CRawlog
+ * \ingroup mrpt_obs_grp
+ */
+class CRawlogIndex
+{
+   public:
+	/** Type of each entry, the first ones with the same values than
+	 * CRawlog::TEntryType */
+	enum TEntryKind : uint8_t
+	{
+		ekSensoryFrame = 0,
+		ekActionCollection,
+		ekObservation,
+		ekOther,
+		/** A CObservationComment (the rawlog comments block) */
+		ekComment,
+		/** A whole CRawlog object */
+		ekRawlog
+	};
+
+#pragma pack(push, 1)
+	struct TFileHeader
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t headerSize;
+		uint64_t numEntries;
+		uint64_t numSorted;
+		uint64_t numStrings;
+		uint64_t sortedOffset;
+		uint64_t stringsOffset;
+		/** The rawlog file (physical) size and modification time, used to
+		 * detect outdated indices */
+		uint64_t rawlogFileSize;
+		int64_t rawlogModifTime;
+		uint8_t reserved[24];
+	};
+	/** The metadata of one top-level object in the rawlog */
+	struct TEntry
+	{
+		/** Position of the object in the uncompressed stream */
+		uint64_t offset;
+		/** Timestamp of observations, the earliest one of the observations
+		 * in a CSensoryFrame or the first action in a CActionCollection;
+		 * INVALID_TIMESTAMP for other objects. */
+		mrpt::system::TTimeStamp timestamp;
+		/** Indices into the string table, see className(), sensorLabel() */
+		uint32_t classNameIdx, sensorLabelIdx;
+		/** A TEntryKind value */
+		uint8_t kind;
+		uint8_t reserved[7];
+	};
+#pragma pack(pop)
+
+	static constexpr uint32_t FILE_VERSION = 1;
+
+	CRawlogIndex() = default;
+	CRawlogIndex(const CRawlogIndex&) = delete;
+	CRawlogIndex& operator=(const CRawlogIndex&) = delete;
+
+	/** Returns `<rawlogFile>.idx` */
+	static std::string defaultIndexFileName(const std::string& rawlogFile);
+
+	/** Reads the given rawlog file sequentially and saves its index into \a
+	 * indexFile (by default, defaultIndexFileName()).
+	 * \param[in] progress If provided, it is called periodically with the
+	 * number of entries and uncompressed bytes read so far.
+	 * \return false on any error reading the rawlog or writing the index.
+	 */
+	static bool build(
+		const std::string& rawlogFile, const std::string& indexFile = {},
+		const std::function<void(size_t, uint64_t)>& progress = {});
+
+	/** Maps an index file into memory.
+	 * \return false if it does not exist or is not a valid index.
+	 */
+	bool open(const std::string& indexFile);
+	/** Closes the index */
+	void close();
+	/** Returns true if open() succeeded */
+	bool isOpen() const { return m_header != nullptr; }
+
+	/** Returns false if the rawlog file has changed (size or modification
+	 * time) since the index was built */
+	bool isUpToDateWith(const std::string& rawlogFile) const;
+
+	/** Number of entries (top-level objects in the rawlog file) */
+	size_t size() const { return m_header ? m_header->numEntries : 0; }
+	/** Metadata of the i'th entry, without bounds checking */
+	const TEntry& entry(size_t i) const { return m_entries[i]; }
+	mrpt::system::TTimeStamp timestamp(size_t i) const
+	{
+		return m_entries[i].timestamp;
+	}
+	TEntryKind kind(size_t i) const
+	{
+		return static_cast<TEntryKind>(m_entries[i].kind);
+	}
+	/** Class name of the i'th entry */
+	const std::string& className(size_t i) const;
+	/** Sensor label of the i'th entry (empty if it is not an observation) */
+	const std::string& sensorLabel(size_t i) const;
+
+	/** Number of entries with a valid timestamp */
+	size_t sortedByTimeSize() const
+	{
+		return m_header ? m_header->numSorted : 0;
+	}
+	/** The index of the k'th entry by ascending timestamp */
+	size_t sortedByTime(size_t k) const { return m_sorted[k]; }
+	/** Returns the position `k` (for sortedByTime()) of the first entry whose
+	 * timestamp is `>= t`, or sortedByTimeSize() if there is none. O(log N).
+	 */
+	size_t lowerBoundByTime(mrpt::system::TTimeStamp t) const;
+
+   private:
+	mrpt::io::CMemoryMappedFile m_file;
+	const TFileHeader* m_header{nullptr};
+	const TEntry* m_entries{nullptr};
+	const uint64_t* m_sorted{nullptr};
+	std::vector<std::string> m_strings;
+};
+
+}  // namespace obs
+}  // namespace mrpt
@@ -289,9 +289,10 @@ void CObservation3DRangeScan::serializeFrom(
 					in.ReadBufferFixEndianness(&points3D_y[0], N);
 					in.ReadBufferFixEndianness(&points3D_z[0], N);
 
-					if (version == 0)
+					if (version == 0 && !in.ReadBufferInPlace(N))
 					{
-						vector<char> validRange(N);  // for v0.
+						// Obsolete field in v0, skipped in-place if possible:
+						vector<char> validRange(N);
 						in.ReadBuffer(
 							&validRange[0], sizeof(validRange[0]) * N);
 					}
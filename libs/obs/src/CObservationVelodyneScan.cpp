@@ -13,6 +13,8 @@
 #include <mrpt/poses/CPose3DInterpolator.h>
 #include <mrpt/core/round.h>
 #include <mrpt/serialization/CArchive.h>
+#include <mrpt/system/CWorkerThreadsPool.h>
+#include <algorithm>
 #include <iostream>
 
 using namespace std;
@@ -136,359 +138,476 @@ double VLP16AdjustTimeStamp(int firingblock, int dsr, int firingwithinblock)
 		   (firingwithinblock * VLP16_FIRING_TOFFSET);
 }
 
-/** Auxiliary class used to refactor
- * CObservationVelodyneScan::generatePointCloud() */
-struct PointCloudStorageWrapper
+/** Max. number of points decoded from one packet */
+const int MAX_POINTS_PER_PACKET =
+	CObservationVelodyneScan::BLOCKS_PER_PACKET * SCANS_PER_FIRING;
+
+/** Fraction of the azimuth increment between consecutive blocks elapsed when
+ * each laser fires, for each block and laser within a packet. It only depends
+ * on the LIDAR model and return mode, so it is computed only once. */
+struct TAzimuthCorrectionTable
+{
+	double frac[CObservationVelodyneScan::BLOCKS_PER_PACKET]
+			   [SCANS_PER_FIRING];
+
+	TAzimuthCorrectionTable(const size_t num_lasers, const bool dual_mode)
+	{
+		for (int block = 0; block < CObservationVelodyneScan::BLOCKS_PER_PACKET;
+			 block++)
+			for (int dsr = 0; dsr < SCANS_PER_FIRING; dsr++)
+			{
+				// [us] since beginning of scan
+				double timestampadjustment = 0.0;
+				double blockdsr0 = 0.0;
+				double nextblockdsr0 = 1.0;
+				switch (num_lasers)
+				{
+					// VLP-16. Note that dsr<16, so all firings are the first
+					// one within their block:
+					case 16:
+					{
+						const int b = dual_mode ? block / 2 : block;
+						timestampadjustment = VLP16AdjustTimeStamp(b, dsr, 0);
+						nextblockdsr0 = VLP16AdjustTimeStamp(b + 1, 0, 0);
+						blockdsr0 = VLP16AdjustTimeStamp(b, 0, 0);
+					}
+					break;
+					// HDL-32:
+					case 32:
+						timestampadjustment = HDL32AdjustTimeStamp(block, dsr);
+						nextblockdsr0 = HDL32AdjustTimeStamp(block + 1, 0);
+						blockdsr0 = HDL32AdjustTimeStamp(block, 0);
+						break;
+				};
+				frac[block][dsr] = (timestampadjustment - blockdsr0) /
+								   (nextblockdsr0 - blockdsr0);
+			}
+	}
+
+	static const TAzimuthCorrectionTable& get(
+		const size_t num_lasers, const bool dual_mode)
+	{
+		static const TAzimuthCorrectionTable vlp16(16, false),
+			vlp16_dual(16, true), hdl32(32, false), hdl64(64, false);
+		switch (num_lasers)
+		{
+			case 16:
+				return dual_mode ? vlp16_dual : vlp16;
+			case 32:
+				return hdl32;
+			case 64:
+				return hdl64;
+			default:
+				THROW_EXCEPTION("Error: unhandled LIDAR model!");
+		};
+	}
+};
+
+/** Calibration of one laser, with the types used while decoding */
+struct TLaserCalib
 {
-	/** Process the insertion of a new (x,y,z) point to the cloud, in
-	 * sensor-centric coordinates, with the exact timestamp of that LIDAR ray */
-	virtual void add_point(
-		double pt_x, double pt_y, double pt_z, uint8_t pt_intensity,
-		const mrpt::system::TTimeStamp& tim, const float azimuth) = 0;
+	float cosVert, sinVert, horzOffset, vertOffset;
+	double distanceCorrection;
 };
 
-static void velodyne_scan_to_pointcloud(
-	const CObservationVelodyneScan& scan,
-	const CObservationVelodyneScan::TGeneratePointCloudParameters& params,
-	PointCloudStorageWrapper& out_pc)
+/** Everything needed to decode the packets of one scan, computed once before
+ * decoding them (possibly in parallel). */
+struct TVelodyneDecodeContext
+{
+	const CObservationVelodyneScan& scan;
+	const CObservationVelodyneScan::TGeneratePointCloudParameters& params;
+	const CSinCosLookUpTableFor2DScans::TSinCosValues* lut_sincos;
+	int minAzimuth_int, maxAzimuth_int;
+	float realMinDist, realMaxDist;
+	int16_t isolatedPointsFilterDistance_units;
+	/** This is: 16,32,64 depending on the LIDAR model */
+	size_t num_lasers;
+	std::vector<TLaserCalib> calib;
+
+	TVelodyneDecodeContext(
+		const CObservationVelodyneScan& scan_,
+		const CObservationVelodyneScan::TGeneratePointCloudParameters& params_)
+		: scan(scan_), params(params_)
+	{
+		// Access to sin/cos table:
+		mrpt::obs::T2DScanProperties scan_props;
+		scan_props.aperture = 2 * M_PI;
+		scan_props.nRays = CObservationVelodyneScan::ROTATION_MAX_UNITS;
+		scan_props.rightToLeft = true;
+		// The LUT contains sin/cos values for angles in this order: [180deg
+		// ... 0 deg ... -180 deg]
+		lut_sincos = &velodyne_sincos_tables.getSinCosForScan(scan_props);
+
+		minAzimuth_int = mrpt::round(params.minAzimuth_deg * 100);
+		maxAzimuth_int = mrpt::round(params.maxAzimuth_deg * 100);
+		realMinDist =
+			std::max(static_cast<float>(scan.minRange), params.minDistance);
+		realMaxDist =
+			std::min(params.maxDistance, static_cast<float>(scan.maxRange));
+		isolatedPointsFilterDistance_units =
+			params.isolatedPointsFilterDistance /
+			CObservationVelodyneScan::DISTANCE_RESOLUTION;
+
+		num_lasers = scan.calibration.laser_corrections.size();
+		calib.resize(num_lasers);
+		for (size_t i = 0; i < num_lasers; i++)
+		{
+			const auto& c = scan.calibration.laser_corrections[i];
+			calib[i].cosVert = c.cosVertCorrection;
+			calib[i].sinVert = c.sinVertCorrection;
+			calib[i].horzOffset = c.horizontalOffsetCorrection;
+			calib[i].vertOffset = c.verticalOffsetCorrection;
+			calib[i].distanceCorrection = c.distanceCorrection;
+		}
+	}
+};
+
+/** Decodes one data packet, calling `out_pc.add_point(x, y, z, intensity,
+ * timestamp, azimuth)` for each point, in sensor-centric coordinates, with
+ * the exact timestamp of that LIDAR ray.
+ * Initially based on code from ROS velodyne & from
+ * vtkVelodyneHDLReader::vtkInternal::ProcessHDLPacket(). */
+template <class POINTCLOUD_SINK>
+static void velodyne_packet_to_pointcloud(
+	const TVelodyneDecodeContext& ctx, const size_t iPkt,
+	POINTCLOUD_SINK& out_pc)
 {
-	// Initially based on code from ROS velodyne & from
-	// vtkVelodyneHDLReader::vtkInternal::ProcessHDLPacket().
 	using mrpt::round;
+	const CObservationVelodyneScan& scan = ctx.scan;
+	const CObservationVelodyneScan::TGeneratePointCloudParameters& params =
+		ctx.params;
+	const CObservationVelodyneScan::TVelodyneRawPacket* raw =
+		&scan.scan_packets[iPkt];
 
-	// Access to sin/cos table:
-	mrpt::obs::T2DScanProperties scan_props;
-	scan_props.aperture = 2 * M_PI;
-	scan_props.nRays = CObservationVelodyneScan::ROTATION_MAX_UNITS;
-	scan_props.rightToLeft = true;
-	// The LUT contains sin/cos values for angles in this order: [180deg ... 0
-	// deg ... -180 deg]
-	const CSinCosLookUpTableFor2DScans::TSinCosValues& lut_sincos =
-		velodyne_sincos_tables.getSinCosForScan(scan_props);
-
-	const int minAzimuth_int = round(params.minAzimuth_deg * 100);
-	const int maxAzimuth_int = round(params.maxAzimuth_deg * 100);
-	const float realMinDist =
-		std::max(static_cast<float>(scan.minRange), params.minDistance);
-	const float realMaxDist =
-		std::min(params.maxDistance, static_cast<float>(scan.maxRange));
-	const int16_t isolatedPointsFilterDistance_units =
-		params.isolatedPointsFilterDistance /
-		CObservationVelodyneScan::DISTANCE_RESOLUTION;
-
-	// This is: 16,32,64 depending on the LIDAR model
-	const size_t num_lasers = scan.calibration.laser_corrections.size();
-
-	for (size_t iPkt = 0; iPkt < scan.scan_packets.size(); iPkt++)
+	mrpt::system::TTimeStamp pkt_tim;  // Find out timestamp of this pkt
 	{
-		const CObservationVelodyneScan::TVelodyneRawPacket* raw =
-			&scan.scan_packets[iPkt];
+		const uint32_t us_pkt0 = scan.scan_packets[0].gps_timestamp;
+		const uint32_t us_pkt_this = raw->gps_timestamp;
+		// Handle the case of time counter reset by new hour 00:00:00
+		const uint32_t us_ellapsed =
+			(us_pkt_this >= us_pkt0)
+				? (us_pkt_this - us_pkt0)
+				: (1000000UL * 3600UL + us_pkt_this - us_pkt0);
+		pkt_tim =
+			mrpt::system::timestampAdd(scan.timestamp, us_ellapsed * 1e-6);
+	}
+
+	const bool dual_mode =
+		raw->laser_return_mode == CObservationVelodyneScan::RETMODE_DUAL;
 
-		mrpt::system::TTimeStamp pkt_tim;  // Find out timestamp of this pkt
+	// Take the median rotational speed as a good value for interpolating
+	// the missing azimuths:
+	int median_azimuth_diff;
+	{
+		// In dual return, the azimuth rate is actually twice this
+		// estimation:
+		const int nBlocksPerAzimuth = dual_mode ? 2 : 1;
+		int diffs[CObservationVelodyneScan::BLOCKS_PER_PACKET];
+		const int nDiffs =
+			CObservationVelodyneScan::BLOCKS_PER_PACKET - nBlocksPerAzimuth;
+		for (int i = 0; i < nDiffs; ++i)
 		{
-			const uint32_t us_pkt0 = scan.scan_packets[0].gps_timestamp;
-			const uint32_t us_pkt_this = raw->gps_timestamp;
-			// Handle the case of time counter reset by new hour 00:00:00
-			const uint32_t us_ellapsed =
-				(us_pkt_this >= us_pkt0)
-					? (us_pkt_this - us_pkt0)
-					: (1000000UL * 3600UL + us_pkt_this - us_pkt0);
-			pkt_tim =
-				mrpt::system::timestampAdd(scan.timestamp, us_ellapsed * 1e-6);
+			int localDiff = (CObservationVelodyneScan::ROTATION_MAX_UNITS +
+							 raw->blocks[i + nBlocksPerAzimuth].rotation -
+							 raw->blocks[i].rotation) %
+							CObservationVelodyneScan::ROTATION_MAX_UNITS;
+			diffs[i] = localDiff;
 		}
+		std::nth_element(
+			diffs, diffs + CObservationVelodyneScan::BLOCKS_PER_PACKET / 2,
+			diffs + nDiffs);  // Calc median
+		median_azimuth_diff =
+			diffs[CObservationVelodyneScan::BLOCKS_PER_PACKET / 2];
+	}
+
+	const TAzimuthCorrectionTable& az_corr =
+		TAzimuthCorrectionTable::get(ctx.num_lasers, dual_mode);
+
+	for (int block = 0; block < CObservationVelodyneScan::BLOCKS_PER_PACKET;
+		 block++)  // Firings per packet
+	{
+		const CObservationVelodyneScan::raw_block_t& blk = raw->blocks[block];
 
-		// Take the median rotational speed as a good value for interpolating
-		// the missing azimuths:
-		int median_azimuth_diff;
+		// ignore packets with mangled or otherwise different contents
+		if ((ctx.num_lasers != 64 &&
+			 CObservationVelodyneScan::UPPER_BANK != blk.header) ||
+			(blk.header != CObservationVelodyneScan::UPPER_BANK &&
+			 blk.header != CObservationVelodyneScan::LOWER_BANK))
 		{
-			// In dual return, the azimuth rate is actually twice this
-			// estimation:
-			const int nBlocksPerAzimuth =
-				(raw->laser_return_mode ==
-				 CObservationVelodyneScan::RETMODE_DUAL)
-					? 2
-					: 1;
-			std::vector<int> diffs(
-				CObservationVelodyneScan::BLOCKS_PER_PACKET -
-				nBlocksPerAzimuth);
-			for (int i = 0; i < CObservationVelodyneScan::BLOCKS_PER_PACKET -
-									nBlocksPerAzimuth;
-				 ++i)
-			{
-				int localDiff = (CObservationVelodyneScan::ROTATION_MAX_UNITS +
-								 raw->blocks[i + nBlocksPerAzimuth].rotation -
-								 raw->blocks[i].rotation) %
-								CObservationVelodyneScan::ROTATION_MAX_UNITS;
-				diffs[i] = localDiff;
-			}
-			std::nth_element(
-				diffs.begin(),
-				diffs.begin() + CObservationVelodyneScan::BLOCKS_PER_PACKET / 2,
-				diffs.end());  // Calc median
-			median_azimuth_diff =
-				diffs[CObservationVelodyneScan::BLOCKS_PER_PACKET / 2];
+			cerr << "[CObservationVelodyneScan] skipping invalid packet: "
+					"block "
+				 << block << " header value is " << blk.header;
+			continue;
 		}
 
-		for (int block = 0; block < CObservationVelodyneScan::BLOCKS_PER_PACKET;
-			 block++)  // Firings per packet
+		const int dsr_offset =
+			(blk.header == CObservationVelodyneScan::LOWER_BANK) ? 32 : 0;
+		const float azimuth_raw_f = (float)(blk.rotation);
+		const bool block_is_dual_2nd_ranges = (dual_mode && ((block & 0x01) != 0));
+		const bool block_is_dual_last_ranges =
+			(dual_mode && ((block & 0x01) == 0));
+		if (block_is_dual_last_ranges && !params.dualKeepLast) continue;
+		if (block_is_dual_2nd_ranges && !params.dualKeepStrongest) continue;
+
+		// 1st stage: select the returns that pass all filters but the
+		// ROI/nROI ones, and gather their data into contiguous arrays:
+		float distance[SCANS_PER_FIRING], cos_vert[SCANS_PER_FIRING],
+			sin_vert[SCANS_PER_FIRING], horz_offset[SCANS_PER_FIRING],
+			vert_offset[SCANS_PER_FIRING], cos_azimuth[SCANS_PER_FIRING],
+			sin_azimuth[SCANS_PER_FIRING], azimuth_f[SCANS_PER_FIRING];
+		int sel[SCANS_PER_FIRING];
+		int n = 0;
+		for (int dsr = 0, k = 0; dsr < SCANS_PER_FIRING; dsr++, k++)
 		{
-			// ignore packets with mangled or otherwise different contents
-			if ((num_lasers != 64 &&
-				 CObservationVelodyneScan::UPPER_BANK !=
-					 raw->blocks[block].header) ||
-				(raw->blocks[block].header !=
-					 CObservationVelodyneScan::UPPER_BANK &&
-				 raw->blocks[block].header !=
-					 CObservationVelodyneScan::LOWER_BANK))
-			{
-				cerr << "[CObservationVelodyneScan] skipping invalid packet: "
-						"block "
-					 << block << " header value is "
-					 << raw->blocks[block].header;
-				continue;
-			}
-
-			const int dsr_offset = (raw->blocks[block].header ==
-									CObservationVelodyneScan::LOWER_BANK)
-									   ? 32
-									   : 0;
-			const float azimuth_raw_f = (float)(raw->blocks[block].rotation);
-			const bool block_is_dual_2nd_ranges =
-				(raw->laser_return_mode ==
-					 CObservationVelodyneScan::RETMODE_DUAL &&
-				 ((block & 0x01) != 0));
-			const bool block_is_dual_last_ranges =
-				(raw->laser_return_mode ==
-					 CObservationVelodyneScan::RETMODE_DUAL &&
-				 ((block & 0x01) == 0));
-
-			for (int dsr = 0, k = 0; dsr < SCANS_PER_FIRING; dsr++, k++)
+			const uint16_t dist_raw = blk.laser_returns[k].distance;
+			if (!dist_raw) continue;  // Invalid return?
+
+			// Detect VLP-16 data and adjust laser id if necessary
+			uint8_t laserId = static_cast<uint8_t>(dsr + dsr_offset);
+			if (ctx.num_lasers == 16 && laserId >= 16) laserId -= 16;
+
+			ASSERT_BELOW_(laserId, ctx.num_lasers);
+			const TLaserCalib& calib = ctx.calib[laserId];
+
+			// In dual return, if the distance is equal in both ranges,
+			// ignore one of them:
+			if (block_is_dual_2nd_ranges &&
+				dist_raw == raw->blocks[block - 1].laser_returns[k].distance)
+				continue;  // duplicated point
+
+			// Return distance:
+			const float dist =
+				dist_raw * CObservationVelodyneScan::DISTANCE_RESOLUTION +
+				calib.distanceCorrection;
+			if (dist < ctx.realMinDist || dist > ctx.realMaxDist) continue;
+
+			// Isolated points filtering:
+			if (params.filterOutIsolatedPoints)
 			{
-				if (!raw->blocks[block]
-						 .laser_returns[k]
-						 .distance)  // Invalid return?
-					continue;
-
-				const uint8_t rawLaserId =
-					static_cast<uint8_t>(dsr + dsr_offset);
-				uint8_t laserId = rawLaserId;
-
-				// Detect VLP-16 data and adjust laser id if necessary
-				bool firingWithinBlock = false;
-				if (num_lasers == 16)
+				bool pass_filter = true;
+				const int16_t dist_this = dist_raw;
+				if (k > 0)
 				{
-					if (laserId >= 16)
-					{
-						laserId -= 16;
-						firingWithinBlock = true;
-					}
+					const int16_t dist_prev =
+						blk.laser_returns[k - 1].distance;
+					if (!dist_prev ||
+						std::abs(dist_this - dist_prev) >
+							ctx.isolatedPointsFilterDistance_units)
+						pass_filter = false;
 				}
-
-				ASSERT_BELOW_(laserId, num_lasers);
-				const mrpt::obs::VelodyneCalibration::PerLaserCalib& calib =
-					scan.calibration.laser_corrections[laserId];
-
-				// In dual return, if the distance is equal in both ranges,
-				// ignore one of them:
-				if (block_is_dual_2nd_ranges)
+				if (k < (SCANS_PER_FIRING - 1))
 				{
-					if (raw->blocks[block].laser_returns[k].distance ==
-						raw->blocks[block - 1].laser_returns[k].distance)
-						continue;  // duplicated point
-					if (!params.dualKeepStrongest) continue;
+					const int16_t dist_next =
+						blk.laser_returns[k + 1].distance;
+					if (!dist_next ||
+						std::abs(dist_this - dist_next) >
+							ctx.isolatedPointsFilterDistance_units)
+						pass_filter = false;
 				}
-				if (block_is_dual_last_ranges && !params.dualKeepLast) continue;
+				if (!pass_filter) continue;  // Filter out this point
+			}
 
-				// Return distance:
-				const float distance =
-					raw->blocks[block].laser_returns[k].distance *
-						CObservationVelodyneScan::DISTANCE_RESOLUTION +
-					calib.distanceCorrection;
-				if (distance < realMinDist || distance > realMaxDist) continue;
+			// Azimuth correction: correct for the laser rotation as a
+			// function of timing during the firings
+			const int azimuthadjustment =
+				mrpt::round(median_azimuth_diff * az_corr.frac[block][dsr]);
+
+			const float azimuth_corrected_f = azimuth_raw_f + azimuthadjustment;
+			const int azimuth_corrected =
+				((int)round(azimuth_corrected_f)) %
+				CObservationVelodyneScan::ROTATION_MAX_UNITS;
+
+			// Filter by azimuth:
+			if (!((ctx.minAzimuth_int < ctx.maxAzimuth_int &&
+				   azimuth_corrected >= ctx.minAzimuth_int &&
+				   azimuth_corrected <= ctx.maxAzimuth_int) ||
+				  (ctx.minAzimuth_int > ctx.maxAzimuth_int &&
+				   (azimuth_corrected <= ctx.maxAzimuth_int ||
+					azimuth_corrected >= ctx.minAzimuth_int))))
+				continue;
 
-				// Isolated points filtering:
-				if (params.filterOutIsolatedPoints)
-				{
-					bool pass_filter = true;
-					const int16_t dist_this =
-						raw->blocks[block].laser_returns[k].distance;
-					if (k > 0)
-					{
-						const int16_t dist_prev =
-							raw->blocks[block].laser_returns[k - 1].distance;
-						if (!dist_prev ||
-							std::abs(dist_this - dist_prev) >
-								isolatedPointsFilterDistance_units)
-							pass_filter = false;
-					}
-					if (k < (SCANS_PER_FIRING - 1))
-					{
-						const int16_t dist_next =
-							raw->blocks[block].laser_returns[k + 1].distance;
-						if (!dist_next ||
-							std::abs(dist_this - dist_next) >
-								isolatedPointsFilterDistance_units)
-							pass_filter = false;
-					}
-					if (!pass_filter) continue;  // Filter out this point
-				}
+			const int azimuth_corrected_for_lut =
+				(azimuth_corrected +
+				 (CObservationVelodyneScan::ROTATION_MAX_UNITS / 2)) %
+				CObservationVelodyneScan::ROTATION_MAX_UNITS;
+
+			distance[n] = dist;
+			cos_vert[n] = calib.cosVert;
+			sin_vert[n] = calib.sinVert;
+			horz_offset[n] = calib.horzOffset;
+			vert_offset[n] = calib.vertOffset;
+			cos_azimuth[n] = ctx.lut_sincos->ccos[azimuth_corrected_for_lut];
+			sin_azimuth[n] = ctx.lut_sincos->csin[azimuth_corrected_for_lut];
+			azimuth_f[n] = azimuth_corrected_f;
+			sel[n] = k;
+			n++;
+		}
 
-				// Azimuth correction: correct for the laser rotation as a
-				// function of timing during the firings
-				double timestampadjustment =
-					0.0;  // [us] since beginning of scan
-				double blockdsr0 = 0.0;
-				double nextblockdsr0 = 1.0;
-				switch (num_lasers)
-				{
-					// VLP-16
-					case 16:
-					{
-						if (raw->laser_return_mode ==
-							CObservationVelodyneScan::RETMODE_DUAL)
-						{
-							timestampadjustment = VLP16AdjustTimeStamp(
-								block / 2, laserId, firingWithinBlock);
-							nextblockdsr0 =
-								VLP16AdjustTimeStamp(block / 2 + 1, 0, 0);
-							blockdsr0 = VLP16AdjustTimeStamp(block / 2, 0, 0);
-						}
-						else
-						{
-							timestampadjustment = VLP16AdjustTimeStamp(
-								block, laserId, firingWithinBlock);
-							nextblockdsr0 =
-								VLP16AdjustTimeStamp(block + 1, 0, 0);
-							blockdsr0 = VLP16AdjustTimeStamp(block, 0, 0);
-						}
-					}
-					break;
-					// HDL-32:
-					case 32:
-						timestampadjustment = HDL32AdjustTimeStamp(block, dsr);
-						nextblockdsr0 = HDL32AdjustTimeStamp(block + 1, 0);
-						blockdsr0 = HDL32AdjustTimeStamp(block, 0);
-						break;
-					case 64:
-						break;
-					default:
-					{
-						THROW_EXCEPTION("Error: unhandled LIDAR model!");
-					}
-				};
+		// 2nd stage: raw positions, in a branchless loop over contiguous
+		// arrays so the compiler can vectorize it:
+		float pt_x[SCANS_PER_FIRING], pt_y[SCANS_PER_FIRING],
+			pt_z[SCANS_PER_FIRING];
+		for (int i = 0; i < n; i++)
+		{
+			// Vertical axis mis-alignment calibration:
+			const float xy_distance = distance[i] * cos_vert[i] +
+									  vert_offset[i] * sin_vert[i];
+			// MRPT +X = Velodyne +Y
+			pt_x[i] = xy_distance * cos_azimuth[i] +
+					  horz_offset[i] * sin_azimuth[i];
+			// MRPT +Y = Velodyne -X
+			pt_y[i] = -(xy_distance * sin_azimuth[i] -
+						horz_offset[i] * cos_azimuth[i]);
+			pt_z[i] = distance[i] * sin_vert[i] + vert_offset[i];
+		}
 
-				const int azimuthadjustment = mrpt::round(
-					median_azimuth_diff * ((timestampadjustment - blockdsr0) /
-										   (nextblockdsr0 - blockdsr0)));
+		// 3rd stage: ROI filters and output:
+		for (int i = 0; i < n; i++)
+		{
+			const float x = pt_x[i], y = pt_y[i], z = pt_z[i];
+			if (params.filterByROI &&
+				(x > params.ROI_x_max || x < params.ROI_x_min ||
+				 y > params.ROI_y_max || y < params.ROI_y_min ||
+				 z > params.ROI_z_max || z < params.ROI_z_min))
+				continue;
 
-				const float azimuth_corrected_f =
-					azimuth_raw_f + azimuthadjustment;
-				const int azimuth_corrected =
-					((int)round(azimuth_corrected_f)) %
-					CObservationVelodyneScan::ROTATION_MAX_UNITS;
+			if (params.filterBynROI &&
+				(x <= params.nROI_x_max && x >= params.nROI_x_min &&
+				 y <= params.nROI_y_max && y >= params.nROI_y_min &&
+				 z <= params.nROI_z_max && z >= params.nROI_z_min))
+				continue;
 
-				// Filter by azimuth:
-				if (!((minAzimuth_int < maxAzimuth_int &&
-					   azimuth_corrected >= minAzimuth_int &&
-					   azimuth_corrected <= maxAzimuth_int) ||
-					  (minAzimuth_int > maxAzimuth_int &&
-					   (azimuth_corrected <= maxAzimuth_int ||
-						azimuth_corrected >= minAzimuth_int))))
-					continue;
-
-				// Vertical axis mis-alignment calibration:
-				const float cos_vert_angle = calib.cosVertCorrection;
-				const float sin_vert_angle = calib.sinVertCorrection;
-				const float horz_offset = calib.horizontalOffsetCorrection;
-				const float vert_offset = calib.verticalOffsetCorrection;
-
-				float xy_distance = distance * cos_vert_angle;
-				if (vert_offset) xy_distance += vert_offset * sin_vert_angle;
-
-				const int azimuth_corrected_for_lut =
-					(azimuth_corrected +
-					 (CObservationVelodyneScan::ROTATION_MAX_UNITS / 2)) %
-					CObservationVelodyneScan::ROTATION_MAX_UNITS;
-				const float cos_azimuth =
-					lut_sincos.ccos[azimuth_corrected_for_lut];
-				const float sin_azimuth =
-					lut_sincos.csin[azimuth_corrected_for_lut];
-
-				// Compute raw position
-				const mrpt::math::TPoint3Df pt(
-					xy_distance * cos_azimuth +
-						horz_offset * sin_azimuth,  // MRPT +X = Velodyne +Y
-					-(xy_distance * sin_azimuth -
-					  horz_offset * cos_azimuth),  // MRPT +Y = Velodyne -X
-					distance * sin_vert_angle + vert_offset);
-
-				bool add_point = true;
-				if (params.filterByROI &&
-					(pt.x > params.ROI_x_max || pt.x < params.ROI_x_min ||
-					 pt.y > params.ROI_y_max || pt.y < params.ROI_y_min ||
-					 pt.z > params.ROI_z_max || pt.z < params.ROI_z_min))
-					add_point = false;
-
-				if (params.filterBynROI &&
-					(pt.x <= params.nROI_x_max && pt.x >= params.nROI_x_min &&
-					 pt.y <= params.nROI_y_max && pt.y >= params.nROI_y_min &&
-					 pt.z <= params.nROI_z_max && pt.z >= params.nROI_z_min))
-					add_point = false;
-
-				if (!add_point) continue;
-
-				// Insert point:
-				out_pc.add_point(
-					pt.x, pt.y, pt.z,
-					raw->blocks[block].laser_returns[k].intensity, pkt_tim,
-					azimuth_corrected_f);
-
-			}  // end for k,dsr=[0,31]
-		}  // end for each block [0,11]
-	}  // end for each data packet
+			// Insert point:
+			out_pc.add_point(
+				x, y, z, blk.laser_returns[sel[i]].intensity, pkt_tim,
+				azimuth_f[i]);
+		}
+	}  // end for each block [0,11]
+}
+
+/** Calls `decode_packet(iPkt)` for each packet in the scan, using
+ * `numThreads` threads (0: one per core) */
+template <class DECODE_PACKET>
+static void velodyne_for_each_packet(
+	const size_t nPackets, unsigned int numThreads,
+	DECODE_PACKET decode_packet)
+{
+	if (numThreads == 0) numThreads = std::thread::hardware_concurrency();
+	if (numThreads <= 1 || nPackets < 2)
+	{
+		for (size_t iPkt = 0; iPkt < nPackets; iPkt++) decode_packet(iPkt);
+		return;
+	}
+	// Each task decodes a block of consecutive packets:
+	const size_t PKTS_PER_TASK =
+		std::max<size_t>(1, nPackets / (4 * numThreads));
+	mrpt::system::CWorkerThreadsPool pool(numThreads);
+	std::vector<std::future<void>> futs;
+	for (size_t p0 = 0; p0 < nPackets; p0 += PKTS_PER_TASK)
+	{
+		const size_t p1 = std::min(nPackets, p0 + PKTS_PER_TASK);
+		futs.emplace_back(pool.enqueue([&decode_packet, p0, p1]() {
+			for (size_t iPkt = p0; iPkt < p1; iPkt++) decode_packet(iPkt);
+		}));
+	}
+	for (auto& f : futs) f.wait();
+	for (auto& f : futs) f.get();
+}
+
+/** Moves the `counts[i]` elements starting at `first+i*MAX_POINTS_PER_PACKET`
+ * right after those of the previous packets, in order. \return The total
+ * number of elements. */
+template <class VECTOR>
+static size_t velodyne_compact_packets(
+	VECTOR& v, const size_t first, const std::vector<uint16_t>& counts)
+{
+	size_t n = first;
+	for (size_t iPkt = 0; iPkt < counts.size(); iPkt++)
+	{
+		const size_t src = first + iPkt * MAX_POINTS_PER_PACKET;
+		if (src != n)
+			std::copy(v.begin() + src, v.begin() + src + counts[iPkt],
+					  v.begin() + n);
+		n += counts[iPkt];
+	}
+	v.resize(n);
+	return n;
 }
 
 void CObservationVelodyneScan::generatePointCloud(
 	const TGeneratePointCloudParameters& params)
 {
-	struct PointCloudStorageWrapper_Inner : public PointCloudStorageWrapper
+	generatePointCloud(point_cloud, params);
+}
+
+void CObservationVelodyneScan::generatePointCloud(
+	TPointCloud& dest, const TGeneratePointCloudParameters& params) const
+{
+	const size_t nPackets = scan_packets.size();
+	if (!nPackets)
 	{
-		CObservationVelodyneScan& me_;
-		const TGeneratePointCloudParameters& params_;
-		PointCloudStorageWrapper_Inner(
-			CObservationVelodyneScan& me,
-			const TGeneratePointCloudParameters& p)
-			: me_(me), params_(p)
-		{
-			// Reset point cloud:
-			me_.point_cloud.clear();
-		}
-		void add_point(
-			double pt_x, double pt_y, double pt_z, uint8_t pt_intensity,
-			const mrpt::system::TTimeStamp& tim, const float azimuth) override
+		dest.clear();
+		return;
+	}
+	const TVelodyneDecodeContext ctx(*this, params);
+
+	// Each packet is decoded straight into its own slot of the output arrays,
+	// which are then compacted:
+	const size_t maxPts = nPackets * MAX_POINTS_PER_PACKET;
+	dest.x.resize(maxPts);
+	dest.y.resize(maxPts);
+	dest.z.resize(maxPts);
+	dest.intensity.resize(maxPts);
+	if (params.generatePerPointTimestamp)
+		dest.timestamp.resize(maxPts);
+	else
+		dest.timestamp.clear();
+	if (params.generatePerPointAzimuth)
+		dest.azimuth.resize(maxPts);
+	else
+		dest.azimuth.clear();
+
+	struct PointCloudStorageWrapper
+	{
+		TPointCloud& pc;
+		const TGeneratePointCloudParameters& params;
+		size_t idx;
+		inline void add_point(
+			float pt_x, float pt_y, float pt_z, uint8_t pt_intensity,
+			const mrpt::system::TTimeStamp& tim, const float azimuth)
 		{
-			me_.point_cloud.x.push_back(pt_x);
-			me_.point_cloud.y.push_back(pt_y);
-			me_.point_cloud.z.push_back(pt_z);
-			me_.point_cloud.intensity.push_back(pt_intensity);
-			if (params_.generatePerPointTimestamp)
-			{
-				me_.point_cloud.timestamp.push_back(tim);
-			}
-			if (params_.generatePerPointAzimuth)
+			pc.x[idx] = pt_x;
+			pc.y[idx] = pt_y;
+			pc.z[idx] = pt_z;
+			pc.intensity[idx] = pt_intensity;
+			if (params.generatePerPointTimestamp) pc.timestamp[idx] = tim;
+			if (params.generatePerPointAzimuth)
 			{
 				const int azimuth_corrected =
-					((int)round(azimuth)) %
+					((int)std::round(azimuth)) %
 					CObservationVelodyneScan::ROTATION_MAX_UNITS;
-				me_.point_cloud.azimuth.push_back(
-					azimuth_corrected * ROTATION_RESOLUTION);
+				pc.azimuth[idx] = azimuth_corrected * ROTATION_RESOLUTION;
 			}
+			idx++;
 		}
 	};
 
-	PointCloudStorageWrapper_Inner my_pc_wrap(*this, params);
-
-	velodyne_scan_to_pointcloud(*this, params, my_pc_wrap);
+	std::vector<uint16_t> counts(nPackets);
+	velodyne_for_each_packet(nPackets, params.numThreads, [&](size_t iPkt) {
+		PointCloudStorageWrapper wrap{dest, params,
+									  iPkt * MAX_POINTS_PER_PACKET};
+		velodyne_packet_to_pointcloud(ctx, iPkt, wrap);
+		counts[iPkt] = wrap.idx - iPkt * MAX_POINTS_PER_PACKET;
+	});
+
+	velodyne_compact_packets(dest.x, 0, counts);
+	velodyne_compact_packets(dest.y, 0, counts);
+	velodyne_compact_packets(dest.z, 0, counts);
+	velodyne_compact_packets(dest.intensity, 0, counts);
+	if (params.generatePerPointTimestamp)
+		velodyne_compact_packets(dest.timestamp, 0, counts);
+	if (params.generatePerPointAzimuth)
+		velodyne_compact_packets(dest.azimuth, 0, counts);
 }
 
 void CObservationVelodyneScan::generatePointCloudAlongSE3Trajectory(
@@ -497,37 +616,38 @@ void CObservationVelodyneScan::generatePointCloudAlongSE3Trajectory(
 	TGeneratePointCloudSE3Results& results_stats,
 	const TGeneratePointCloudParameters& params)
 {
-	// Pre-alloc mem:
-	out_points.reserve(
-		out_points.size() +
-		scan_packets.size() * BLOCKS_PER_PACKET * SCANS_PER_BLOCK + 16);
+	const size_t nPackets = scan_packets.size();
+	if (!nPackets) return;
+	const TVelodyneDecodeContext ctx(*this, params);
+
+	// As in generatePointCloud(), each packet is decoded into its own slot:
+	const size_t nOldPts = out_points.size();
+	out_points.resize(nOldPts + nPackets * MAX_POINTS_PER_PACKET);
 
-	struct PointCloudStorageWrapper_SE3_Interp : public PointCloudStorageWrapper
+	struct PointCloudStorageWrapper_SE3_Interp
 	{
-		CObservationVelodyneScan& me_;
+		const CObservationVelodyneScan& me_;
 		const mrpt::poses::CPose3DInterpolator& vehicle_path_;
 		std::vector<mrpt::math::TPointXYZIu8>& out_points_;
-		TGeneratePointCloudSE3Results& results_stats_;
-		mrpt::system::TTimeStamp last_query_tim_;
+		size_t idx_;
+		size_t num_points_{0};
+		mrpt::system::TTimeStamp last_query_tim_{INVALID_TIMESTAMP};
 		mrpt::poses::CPose3D last_query_;
-		bool last_query_valid_;
+		bool last_query_valid_{false};
 
 		PointCloudStorageWrapper_SE3_Interp(
-			CObservationVelodyneScan& me,
+			const CObservationVelodyneScan& me,
 			const mrpt::poses::CPose3DInterpolator& vehicle_path,
-			std::vector<mrpt::math::TPointXYZIu8>& out_points,
-			TGeneratePointCloudSE3Results& results_stats)
+			std::vector<mrpt::math::TPointXYZIu8>& out_points, size_t idx)
 			: me_(me),
 			  vehicle_path_(vehicle_path),
 			  out_points_(out_points),
-			  results_stats_(results_stats),
-			  last_query_tim_(INVALID_TIMESTAMP),
-			  last_query_valid_(false)
+			  idx_(idx)
 		{
 		}
-		void add_point(
-			double pt_x, double pt_y, double pt_z, uint8_t pt_intensity,
-			const mrpt::system::TTimeStamp& tim, const float azimuth) override
+		inline void add_point(
+			float pt_x, float pt_y, float pt_z, uint8_t pt_intensity,
+			const mrpt::system::TTimeStamp& tim, const float azimuth)
 		{
 			// Use a cache since it's expected that the same timestamp is
 			// queried several times in a row:
@@ -544,17 +664,28 @@ void CObservationVelodyneScan::generatePointCloudAlongSE3Trajectory(
 				global_sensor_pose.composeFrom(last_query_, me_.sensorPose);
 				double gx, gy, gz;
 				global_sensor_pose.composePoint(pt_x, pt_y, pt_z, gx, gy, gz);
-				out_points_.push_back(
-					mrpt::math::TPointXYZIu8(gx, gy, gz, pt_intensity));
-				++results_stats_.num_correctly_inserted_points;
+				out_points_[idx_++] =
+					mrpt::math::TPointXYZIu8(gx, gy, gz, pt_intensity);
 			}
-			++results_stats_.num_points;
+			++num_points_;
 		}
 	};
 
-	PointCloudStorageWrapper_SE3_Interp my_pc_wrap(
-		*this, vehicle_path, out_points, results_stats);
-	velodyne_scan_to_pointcloud(*this, params, my_pc_wrap);
+	std::vector<uint16_t> counts(nPackets);
+	std::vector<size_t> num_points(nPackets);
+	velodyne_for_each_packet(nPackets, params.numThreads, [&](size_t iPkt) {
+		const size_t first = nOldPts + iPkt * MAX_POINTS_PER_PACKET;
+		PointCloudStorageWrapper_SE3_Interp wrap(
+			*this, vehicle_path, out_points, first);
+		velodyne_packet_to_pointcloud(ctx, iPkt, wrap);
+		counts[iPkt] = wrap.idx_ - first;
+		num_points[iPkt] = wrap.num_points_;
+	});
+
+	const size_t nNewPts =
+		velodyne_compact_packets(out_points, nOldPts, counts) - nOldPts;
+	results_stats.num_correctly_inserted_points += nNewPts;
+	for (const size_t n : num_points) results_stats.num_points += n;
 }
 
 void CObservationVelodyneScan::TPointCloud::clear()
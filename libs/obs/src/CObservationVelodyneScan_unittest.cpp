@@ -0,0 +1,232 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/obs/CObservationVelodyneScan.h>
+#include <mrpt/poses/CPose3DInterpolator.h>
+#include <mrpt/random.h>
+#include <gtest/gtest.h>
+#include <cmath>
+
+using namespace mrpt;
+using namespace mrpt::obs;
+using namespace std;
+
+namespace
+{
+// Builds a scan with random returns, with the packet layout of each model:
+void makeRandomScan(
+	CObservationVelodyneScan& scan, const std::string& model,
+	const uint8_t returnMode, const size_t nPackets)
+{
+	auto& rng = mrpt::random::getRandomGenerator();
+	rng.randomize(1234);
+
+	scan.calibration = VelodyneCalibration::LoadDefaultCalibration(model);
+	scan.timestamp = mrpt::system::TTimeStamp(1000000000);
+	scan.minRange = 0.5;
+	scan.maxRange = 100.0;
+	scan.scan_packets.resize(nPackets);
+
+	uint16_t rotation = 35000;
+	for (size_t i = 0; i < nPackets; i++)
+	{
+		auto& pkt = scan.scan_packets[i];
+		pkt.gps_timestamp = 3599000000UL + 553 * i;  // Wraps around 1h
+		pkt.gps_timestamp %= 3600000000UL;
+		pkt.laser_return_mode = returnMode;
+		pkt.velodyne_model_ID = model == "VLP16" ? 0x22 : 0x21;
+		for (int b = 0; b < CObservationVelodyneScan::BLOCKS_PER_PACKET; b++)
+		{
+			auto& blk = pkt.blocks[b];
+			blk.header = CObservationVelodyneScan::UPPER_BANK;
+			const bool dual2nd =
+				returnMode == CObservationVelodyneScan::RETMODE_DUAL && (b & 1);
+			if (!dual2nd)
+				rotation = (rotation + 18 + rng.drawUniform32bit() % 4) %
+						   CObservationVelodyneScan::ROTATION_MAX_UNITS;
+			blk.rotation = rotation;
+			for (int k = 0; k < CObservationVelodyneScan::SCANS_PER_BLOCK; k++)
+			{
+				auto& ret = blk.laser_returns[k];
+				const unsigned r = rng.drawUniform32bit() % 10;
+				if (dual2nd && r < 3)
+					ret.distance = pkt.blocks[b - 1].laser_returns[k].distance;
+				else
+					ret.distance =
+						r == 0 ? 0
+							   : static_cast<uint16_t>(
+									 100 + rng.drawUniform32bit() % 30000);
+				ret.intensity = rng.drawUniform32bit() % 256;
+			}
+		}
+	}
+}
+
+struct TCloudStats
+{
+	size_t n{0};
+	double sx{0}, sy{0}, sz{0}, si{0}, st{0}, sa{0};
+};
+
+TCloudStats cloudStats(const CObservationVelodyneScan::TPointCloud& pc)
+{
+	TCloudStats s;
+	s.n = pc.size();
+	for (size_t i = 0; i < s.n; i++)
+	{
+		s.sx += pc.x[i];
+		s.sy += pc.y[i];
+		s.sz += pc.z[i];
+		s.si += pc.intensity[i];
+		if (!pc.timestamp.empty())
+			s.st += (pc.timestamp[i] - pc.timestamp[0]) * 1e-7;
+		if (!pc.azimuth.empty()) s.sa += pc.azimuth[i];
+	}
+	return s;
+}
+
+void checkStats(
+	const TCloudStats& s, const size_t n, const double sx, const double sy,
+	const double sz, const double si, const double st, const double sa,
+	const std::string& ctx)
+{
+	const auto tol = [](double v) { return 1e-6 + std::abs(v) * 1e-9; };
+	EXPECT_EQ(s.n, n) << ctx;
+	EXPECT_NEAR(s.sx, sx, tol(sx)) << ctx;
+	EXPECT_NEAR(s.sy, sy, tol(sy)) << ctx;
+	EXPECT_NEAR(s.sz, sz, tol(sz)) << ctx;
+	EXPECT_NEAR(s.si, si, tol(si)) << ctx;
+	EXPECT_NEAR(s.st, st, tol(st)) << ctx;
+	EXPECT_NEAR(s.sa, sa, tol(sa)) << ctx;
+}
+}  // namespace
+
+// Checks the decoder output against values generated with the original
+// (serial, point by point) implementation:
+TEST(CObservationVelodyneScan, generatePointCloud)
+{
+	struct TCase
+	{
+		const char* model;
+		uint8_t retMode;
+		// Point count and sums of x,y,z,intensity,time,azimuth for:
+		// default params, ROI+azimuth filter, isolated+dual filters:
+		double expected[3][7];
+		// SE(3): num_points, inserted, out size, sums of x,y,z,intensity:
+		double expectedSE3[7];
+	};
+	const TCase cases[] = {
+		{"HDL32",
+		 CObservationVelodyneScan::RETMODE_STRONGEST,
+		 {{8535, 136265.299748, -155022.397861, -67423.035357, 1103825.0,
+		   115.362816, 673311.675291},
+		  {1299, 15753.202449, -13425.921583, -442.972922, 170940.0,
+		   14.902772, 102251.667995},
+		  {4267, 66501.269338, -77880.910067, -33334.192997, 554333.0, 0, 0}},
+		 {8535, 8535, 8538, 174337.486830, -120042.286335, -58455.481060,
+		  1103825.0}},
+		{"VLP16",
+		 CObservationVelodyneScan::RETMODE_STRONGEST,
+		 {{8535, 142124.062467, -161599.049109, 283.871678, 1103825.0,
+		   115.362816, 673621.124899},
+		  {4441, 84134.352869, -70619.798599, 15050.862208, 576626.0,
+		   50.689002, 334644.692487},
+		  {4267, 69395.736064, -81176.045049, 113.547658, 554333.0, 0, 0}},
+		 {8535, 8535, 8538, 181407.386697, -125310.126573, 9251.425975,
+		  1103825.0}},
+		{"VLP16",
+		 CObservationVelodyneScan::RETMODE_DUAL,
+		 {{7581, 205934.638015, -73178.581423, 230.030506, 966351.0,
+		   103.170293, 597407.087087},
+		  {4664, 117271.721086, -41604.879366, 15700.781455, 593035.0,
+		   63.510850, 367471.582002},
+		  {2115, 56776.396639, -20537.827639, -136.902333, 266810.0, 0, 0}},
+		 {7581, 7581, 7584, 224981.420438, -26231.952947, 8195.270960,
+		  966351.0}}};
+
+	for (const auto& c : cases)
+	{
+		CObservationVelodyneScan scan;
+		makeRandomScan(scan, c.model, c.retMode, 50);
+
+		for (const unsigned int nThreads : {1u, 4u})
+		{
+			const std::string ctx = mrpt::format(
+				"model=%s retMode=%u numThreads=%u", c.model,
+				static_cast<unsigned>(c.retMode), nThreads);
+
+			CObservationVelodyneScan::TGeneratePointCloudParameters p;
+			p.numThreads = nThreads;
+			p.generatePerPointTimestamp = true;
+			p.generatePerPointAzimuth = true;
+			scan.generatePointCloud(p);
+			const auto* e = c.expected[0];
+			checkStats(
+				cloudStats(scan.point_cloud), e[0], e[1], e[2], e[3], e[4],
+				e[5], e[6], ctx + " default");
+
+			p.filterByROI = true;
+			p.ROI_z_min = -1.0f;
+			p.minAzimuth_deg = 300;
+			p.maxAzimuth_deg = 90;
+			scan.generatePointCloud(p);
+			e = c.expected[1];
+			checkStats(
+				cloudStats(scan.point_cloud), e[0], e[1], e[2], e[3], e[4],
+				e[5], e[6], ctx + " ROI");
+
+			// Reusing an external cloud:
+			p = CObservationVelodyneScan::TGeneratePointCloudParameters();
+			p.numThreads = nThreads;
+			p.filterOutIsolatedPoints = true;
+			p.isolatedPointsFilterDistance = 30.0f;
+			p.dualKeepStrongest = false;
+			CObservationVelodyneScan::TPointCloud pc = scan.point_cloud;
+			scan.generatePointCloud(pc, p);
+			e = c.expected[2];
+			checkStats(
+				cloudStats(pc), e[0], e[1], e[2], e[3], e[4], e[5], e[6],
+				ctx + " isolated");
+			EXPECT_TRUE(pc.timestamp.empty());
+			EXPECT_TRUE(pc.azimuth.empty());
+
+			mrpt::poses::CPose3DInterpolator path;
+			path.insert(
+				mrpt::system::timestampAdd(scan.timestamp, -1.0),
+				mrpt::math::TPose3D(0, 0, 0, 0, 0, 0));
+			path.insert(
+				mrpt::system::timestampAdd(scan.timestamp, 1.0),
+				mrpt::math::TPose3D(2.0, 1.0, 0.1, 0.4, 0, 0));
+			scan.sensorPose = mrpt::poses::CPose3D(0.1, 0, 1.0, 0, 0, 0);
+			// Previous contents must be kept:
+			std::vector<mrpt::math::TPointXYZIu8> pts(
+				3, mrpt::math::TPointXYZIu8(0, 0, 0, 7));
+			CObservationVelodyneScan::TGeneratePointCloudSE3Results res;
+			p = CObservationVelodyneScan::TGeneratePointCloudParameters();
+			p.numThreads = nThreads;
+			scan.generatePointCloudAlongSE3Trajectory(path, pts, res, p);
+			TCloudStats s;
+			for (size_t i = 3; i < pts.size(); i++)
+			{
+				const auto& pt = pts[i];
+				s.sx += pt.pt.x;
+				s.sy += pt.pt.y;
+				s.sz += pt.pt.z;
+				s.si += pt.intensity;
+			}
+			e = c.expectedSE3;
+			EXPECT_EQ(res.num_points, e[0]) << ctx;
+			EXPECT_EQ(res.num_correctly_inserted_points, e[1]) << ctx;
+			ASSERT_EQ(pts.size(), e[2]) << ctx;
+			for (int i = 0; i < 3; i++) EXPECT_EQ(pts[i].intensity, 7) << ctx;
+			s.n = pts.size();
+			checkStats(s, e[2], e[3], e[4], e[5], e[6], 0, 0, ctx + " SE3");
+		}
+	}
+}
@@ -11,10 +11,14 @@
 
 #include <mrpt/system/filesystem.h>
 #include <mrpt/obs/CRawlog.h>
+#include <mrpt/obs/CRawlogIndex.h>
 #include <mrpt/io/CFileInputStream.h>
 #include <mrpt/io/CFileGZInputStream.h>
 #include <mrpt/io/CFileGZOutputStream.h>
 #include <mrpt/serialization/CArchive.h>
+#include <list>
+#include <mutex>
+#include <unordered_map>
 
 using namespace mrpt;
 using namespace mrpt::io;
@@ -25,18 +29,97 @@ using namespace mrpt::serialization;
 
 IMPLEMENTS_SERIALIZABLE(CRawlog, CSerializable, mrpt::obs)
 
+struct CRawlog::TLazyBackend
+{
+	std::string rawlogFile;
+	CRawlogIndex index;
+	/** CRawlog entry `i` is the index entry `firstEntry+i`, or
+	 * `entryMap[i]` if it is not empty. */
+	size_t firstEntry{0}, numEntries{0};
+	std::vector<uint64_t> entryMap;
+
+	/** Protects all the members below */
+	std::mutex mtx;
+	CFileGZInputStream stream;
+	size_t cacheMaxSize{256};
+	/** Most recently used entries first */
+	std::list<size_t> lru;
+	std::unordered_map<
+		size_t, std::pair<CSerializable::Ptr, std::list<size_t>::iterator>>
+		cache;
+
+	size_t fileEntry(size_t i) const
+	{
+		return entryMap.empty() ? firstEntry + i : entryMap[i];
+	}
+
+	CSerializable::Ptr get(size_t i)
+	{
+		std::lock_guard<std::mutex> lck(mtx);
+		auto it = cache.find(i);
+		if (it != cache.end())
+		{
+			lru.splice(lru.begin(), lru, it->second.second);
+			return it->second.first;
+		}
+		const uint64_t offset = index.entry(fileEntry(i)).offset;
+		if (stream.getPosition() != offset) stream.Seek(offset);
+		CSerializable::Ptr obj = archiveFrom(stream).ReadObject();
+
+		lru.push_front(i);
+		cache[i] = std::make_pair(obj, lru.begin());
+		trimCache();
+		return obj;
+	}
+
+	void trimCache()
+	{
+		while (cache.size() > cacheMaxSize)
+		{
+			cache.erase(lru.back());
+			lru.pop_back();
+		}
+	}
+};
+
 // ctor
 CRawlog::CRawlog() : m_seqOfActObs(), m_commentTexts() {}
 // dtor
 CRawlog::~CRawlog() { clear(); }
 void CRawlog::clear()
 {
+	m_lazy.reset();
 	m_seqOfActObs.clear();
 	m_commentTexts.text.clear();
 }
 
+CSerializable::Ptr CRawlog::getEntry(size_t index) const
+{
+	return m_lazy ? m_lazy->get(index) : m_seqOfActObs[index];
+}
+
+void CRawlog::loadAllLazyEntries() const
+{
+	MRPT_START
+	if (!m_lazy) return;
+	TListObjects objs(m_lazy->numEntries);
+	for (size_t i = 0; i < objs.size(); i++) objs[i] = m_lazy->get(i);
+	m_seqOfActObs.swap(objs);
+	m_lazy.reset();
+	MRPT_END
+}
+
+void CRawlog::setLazyCacheSize(size_t maxEntries)
+{
+	if (!m_lazy) return;
+	std::lock_guard<std::mutex> lck(m_lazy->mtx);
+	m_lazy->cacheMaxSize = maxEntries;
+	m_lazy->trimCache();
+}
+
 void CRawlog::addObservations(CSensoryFrame& observations)
 {
+	ensureNotLazy();
 	m_seqOfActObs.push_back(
 		std::dynamic_pointer_cast<CSerializable>(
 			observations.duplicateGetSmartPtr()));
@@ -44,6 +127,7 @@ void CRawlog::addObservations(CSensoryFrame& observations)
 
 void CRawlog::addActions(CActionCollection& actions)
 {
+	ensureNotLazy();
 	m_seqOfActObs.push_back(
 		std::dynamic_pointer_cast<CSerializable>(
 			actions.duplicateGetSmartPtr()));
@@ -51,16 +135,19 @@ void CRawlog::addActions(CActionCollection& actions)
 
 void CRawlog::addActionsMemoryReference(const CActionCollection::Ptr& action)
 {
+	ensureNotLazy();
 	m_seqOfActObs.push_back(action);
 }
 
 void CRawlog::addObservationsMemoryReference(
 	const CSensoryFrame::Ptr& observations)
 {
+	ensureNotLazy();
 	m_seqOfActObs.push_back(observations);
 }
 void CRawlog::addGenericObject(const CSerializable::Ptr& obj)
 {
+	ensureNotLazy();
 	m_seqOfActObs.push_back(obj);
 }
 
@@ -74,7 +161,10 @@ void CRawlog::addObservationMemoryReference(
 		m_commentTexts = *o;
 	}
 	else
+	{
+		ensureNotLazy();
 		m_seqOfActObs.push_back(observation);
+	}
 }
 
 void CRawlog::addAction(CAction& action)
@@ -82,17 +172,21 @@ void CRawlog::addAction(CAction& action)
 	CActionCollection::Ptr temp =
 		mrpt::make_aligned_shared<CActionCollection>();
 	temp->insert(action);
+	ensureNotLazy();
 	m_seqOfActObs.push_back(temp);
 }
 
-size_t CRawlog::size() const { return m_seqOfActObs.size(); }
+size_t CRawlog::size() const
+{
+	return m_lazy ? m_lazy->numEntries : m_seqOfActObs.size();
+}
 CActionCollection::Ptr CRawlog::getAsAction(size_t index) const
 {
 	MRPT_START
 
-	if (index >= m_seqOfActObs.size()) THROW_EXCEPTION("Index out of bounds");
+	if (index >= size()) THROW_EXCEPTION("Index out of bounds");
 
-	CSerializable::Ptr obj = m_seqOfActObs[index];
+	CSerializable::Ptr obj = getEntry(index);
 
 	if (obj->GetRuntimeClass() == CLASS_ID(CActionCollection))
 		return std::dynamic_pointer_cast<CActionCollection>(obj);
@@ -106,9 +200,9 @@ CObservation::Ptr CRawlog::getAsObservation(size_t index) const
 {
 	MRPT_START
 
-	if (index >= m_seqOfActObs.size()) THROW_EXCEPTION("Index out of bounds");
+	if (index >= size()) THROW_EXCEPTION("Index out of bounds");
 
-	CSerializable::Ptr obj = m_seqOfActObs[index];
+	CSerializable::Ptr obj = getEntry(index);
 
 	if (obj->GetRuntimeClass()->derivedFrom(CLASS_ID(CObservation)))
 		return std::dynamic_pointer_cast<CObservation>(obj);
@@ -121,16 +215,31 @@ CObservation::Ptr CRawlog::getAsObservation(size_t index) const
 CSerializable::Ptr CRawlog::getAsGeneric(size_t index) const
 {
 	MRPT_START
-	if (index >= m_seqOfActObs.size()) THROW_EXCEPTION("Index out of bounds");
+	if (index >= size()) THROW_EXCEPTION("Index out of bounds");
 
-	return m_seqOfActObs[index];
+	return getEntry(index);
 	MRPT_END
 }
 
 CRawlog::TEntryType CRawlog::getType(size_t index) const
 {
 	MRPT_START
-	if (index >= m_seqOfActObs.size()) THROW_EXCEPTION("Index out of bounds");
+	if (index >= size()) THROW_EXCEPTION("Index out of bounds");
+
+	if (m_lazy)
+	{
+		switch (m_lazy->index.kind(m_lazy->fileEntry(index)))
+		{
+			case CRawlogIndex::ekObservation:
+				return etObservation;
+			case CRawlogIndex::ekActionCollection:
+				return etActionCollection;
+			case CRawlogIndex::ekSensoryFrame:
+				return etSensoryFrame;
+			default:
+				return etOther;
+		};
+	}
 
 	const CSerializable::Ptr& obj = m_seqOfActObs[index];
 
@@ -149,9 +258,9 @@ CRawlog::TEntryType CRawlog::getType(size_t index) const
 CSensoryFrame::Ptr CRawlog::getAsObservations(size_t index) const
 {
 	MRPT_START
-	if (index >= m_seqOfActObs.size()) THROW_EXCEPTION("Index out of bounds");
+	if (index >= size()) THROW_EXCEPTION("Index out of bounds");
 
-	CSerializable::Ptr obj = m_seqOfActObs[index];
+	CSerializable::Ptr obj = getEntry(index);
 
 	if (obj->GetRuntimeClass()->derivedFrom(CLASS_ID(CSensoryFrame)))
 		return std::dynamic_pointer_cast<CSensoryFrame>(obj);
@@ -164,8 +273,9 @@ CSensoryFrame::Ptr CRawlog::getAsObservations(size_t index) const
 uint8_t CRawlog::serializeGetVersion() const { return 1; }
 void CRawlog::serializeTo(mrpt::serialization::CArchive& out) const
 {
-	out.WriteAs<uint32_t>(m_seqOfActObs.size());
-	for (const auto& a : m_seqOfActObs) out << a;
+	const size_t N = size();
+	out.WriteAs<uint32_t>(N);
+	for (size_t i = 0; i < N; i++) out << getEntry(i);
 	out << m_commentTexts;
 }
 
@@ -267,9 +377,75 @@ bool CRawlog::loadFromRawLogFile(
 	return true;
 }
 
+bool CRawlog::loadFromRawLogFileLazy(
+	const std::string& fileName, bool non_obs_objects_are_legal,
+	bool buildIndexIfNeeded, const std::string& indexFile_)
+{
+	MRPT_START
+
+	clear();
+	const std::string indexFile =
+		indexFile_.empty() ? CRawlogIndex::defaultIndexFileName(fileName)
+						   : indexFile_;
+	auto lazy = std::make_shared<TLazyBackend>();
+	lazy->rawlogFile = fileName;
+	if (!lazy->index.open(indexFile) ||
+		!lazy->index.isUpToDateWith(fileName))
+	{
+		lazy->index.close();
+		if (!buildIndexIfNeeded || !CRawlogIndex::build(fileName, indexFile) ||
+			!lazy->index.open(indexFile))
+			return false;
+	}
+	if (!lazy->stream.open(fileName)) return false;
+
+	// Same rules than loadFromRawLogFile() to decide which entries are part
+	// of the rawlog:
+	const CRawlogIndex& idx = lazy->index;
+	const size_t N = idx.size();
+	size_t nEntries = 0;
+	std::vector<uint64_t> entryMap;
+	bool isIdentity = true;
+	for (size_t e = 0; e < N; e++)
+	{
+		const auto kind = idx.kind(e);
+		if (kind == CRawlogIndex::ekRawlog)
+		{
+			// An entire CRawlog object: can't be loaded lazily
+			lazy.reset();
+			return loadFromRawLogFile(fileName, non_obs_objects_are_legal);
+		}
+		if (kind == CRawlogIndex::ekOther && !non_obs_objects_are_legal)
+			break;
+		if (kind == CRawlogIndex::ekComment)
+		{
+			const uint64_t offset = idx.entry(e).offset;
+			if (lazy->stream.getPosition() != offset)
+				lazy->stream.Seek(offset);
+			archiveFrom(lazy->stream) >> m_commentTexts;
+			// Comments are usually only found at the beginning:
+			if (nEntries == 0)
+				lazy->firstEntry = e + 1;
+			else
+				isIdentity = false;
+			continue;
+		}
+		entryMap.push_back(e);
+		nEntries++;
+	}
+	lazy->numEntries = nEntries;
+	if (!isIdentity) lazy->entryMap.swap(entryMap);
+
+	m_lazy = lazy;
+	return true;
+
+	MRPT_END
+}
+
 void CRawlog::remove(size_t index)
 {
 	MRPT_START
+	ensureNotLazy();
 	if (index >= m_seqOfActObs.size()) THROW_EXCEPTION("Index out of bounds");
 	m_seqOfActObs.erase(m_seqOfActObs.begin() + index);
 	MRPT_END
@@ -278,6 +454,7 @@ void CRawlog::remove(size_t index)
 void CRawlog::remove(size_t first_index, size_t last_index)
 {
 	MRPT_START
+	ensureNotLazy();
 	if (first_index >= m_seqOfActObs.size() ||
 		last_index >= m_seqOfActObs.size())
 		THROW_EXCEPTION("Index out of bounds");
@@ -294,8 +471,7 @@ bool CRawlog::saveToRawLogFile(const std::string& fileName) const
 		CFileGZOutputStream fo(fileName);
 		auto f = archiveFrom(fo);
 		if (!m_commentTexts.text.empty()) f << m_commentTexts;
-		for (size_t i = 0; i < m_seqOfActObs.size(); i++)
-			f << *m_seqOfActObs[i];
+		for (size_t i = 0; i < size(); i++) f << *getEntry(i);
 		return true;
 	}
 	catch (...)
@@ -311,8 +487,10 @@ void CRawlog::moveFrom(CRawlog& obj)
 	clear();
 	m_commentTexts = obj.m_commentTexts;
 	m_seqOfActObs = obj.m_seqOfActObs;
+	m_lazy = obj.m_lazy;
 	obj.m_seqOfActObs.clear();
 	obj.m_commentTexts.text.clear();
+	obj.m_lazy.reset();
 	MRPT_END
 }
 
@@ -320,6 +498,7 @@ void CRawlog::swap(CRawlog& obj)
 {
 	if (this == &obj) return;
 	m_seqOfActObs.swap(obj.m_seqOfActObs);
+	m_lazy.swap(obj.m_lazy);
 	std::swap(m_commentTexts, obj.m_commentTexts);
 }
 
@@ -454,6 +633,49 @@ void CRawlog::findObservationsByClassInRange(
 
 	out_found.clear();
 
+	if (m_lazy)
+	{
+		// Use the timestamps in the index, loading only the entries found:
+		const CRawlogIndex& idx = m_lazy->index;
+		const auto& entryMap = m_lazy->entryMap;
+		for (size_t k = idx.lowerBoundByTime(time_start);
+			 k < idx.sortedByTimeSize(); k++)
+		{
+			const size_t e = idx.sortedByTime(k);
+			const TTimeStamp this_timestamp = idx.timestamp(e);
+			if (this_timestamp >= time_end) break;  // end of time window!
+
+			// From index entry to rawlog entry:
+			size_t i;
+			if (entryMap.empty())
+			{
+				if (e < m_lazy->firstEntry ||
+					e >= m_lazy->firstEntry + m_lazy->numEntries)
+					continue;
+				i = e - m_lazy->firstEntry;
+			}
+			else
+			{
+				const auto it =
+					std::lower_bound(entryMap.begin(), entryMap.end(), e);
+				if (it == entryMap.end() || *it != e) continue;
+				i = it - entryMap.begin();
+			}
+			if (idx.kind(e) != CRawlogIndex::ekObservation)
+				THROW_EXCEPTION(
+					"Element found which is not derived from CObservation");
+
+			const auto* cls =
+				mrpt::rtti::findRegisteredClass(idx.className(e));
+			if (cls && cls->derivedFrom(class_type))
+				out_found.insert(
+					TTimeObservationPair(
+						this_timestamp, std::dynamic_pointer_cast<CObservation>(
+											m_lazy->get(i))));
+		}
+		return;
+	}
+
 	if (m_seqOfActObs.empty()) return;
 
 	// Find the first appearance of time_start:
@@ -0,0 +1,279 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include "obs-precomp.h"  // Precompiled headers
+
+#include <mrpt/obs/CRawlogIndex.h>
+#include <mrpt/obs/CRawlog.h>
+#include <mrpt/io/CFileGZInputStream.h>
+#include <mrpt/io/CFileOutputStream.h>
+#include <mrpt/serialization/CArchive.h>
+#include <mrpt/system/filesystem.h>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <map>
+
+using namespace mrpt;
+using namespace mrpt::io;
+using namespace mrpt::obs;
+using namespace mrpt::serialization;
+using namespace mrpt::system;
+
+static_assert(sizeof(CRawlogIndex::TFileHeader) == 96, "Unexpected size");
+static_assert(sizeof(CRawlogIndex::TEntry) == 32, "Unexpected size");
+
+static const char RAWLOG_INDEX_MAGIC[8] = {'M', 'R', 'P', 'T',
+										   'R', 'I', 'D', 'X'};
+
+std::string CRawlogIndex::defaultIndexFileName(const std::string& rawlogFile)
+{
+	return rawlogFile + std::string(".idx");
+}
+
+// Fills the metadata of one rawlog object:
+static void getEntryMetadata(
+	const CSerializable::Ptr& obj, CRawlogIndex::TEntry& e,
+	std::string& sensorLabel)
+{
+	e.timestamp = INVALID_TIMESTAMP;
+	sensorLabel.clear();
+	if (IS_CLASS(obj, CObservationComment))
+		e.kind = CRawlogIndex::ekComment;
+	else if (IS_DERIVED(obj, CObservation))
+	{
+		const auto o = std::dynamic_pointer_cast<CObservation>(obj);
+		e.kind = CRawlogIndex::ekObservation;
+		e.timestamp = o->timestamp;
+		sensorLabel = o->sensorLabel;
+	}
+	else if (IS_CLASS(obj, CSensoryFrame))
+	{
+		const auto sf = std::dynamic_pointer_cast<CSensoryFrame>(obj);
+		e.kind = CRawlogIndex::ekSensoryFrame;
+		for (const auto& o : *sf)
+			if (o->timestamp != INVALID_TIMESTAMP &&
+				(e.timestamp == INVALID_TIMESTAMP || o->timestamp < e.timestamp))
+				e.timestamp = o->timestamp;
+	}
+	else if (IS_CLASS(obj, CActionCollection))
+	{
+		const auto acts = std::dynamic_pointer_cast<CActionCollection>(obj);
+		e.kind = CRawlogIndex::ekActionCollection;
+		if (acts->size() > 0) e.timestamp = acts->get(0)->timestamp;
+	}
+	else if (IS_CLASS(obj, CRawlog))
+		e.kind = CRawlogIndex::ekRawlog;
+	else
+		e.kind = CRawlogIndex::ekOther;
+}
+
+bool CRawlogIndex::build(
+	const std::string& rawlogFile, const std::string& indexFile_,
+	const std::function<void(size_t, uint64_t)>& progress)
+{
+	const std::string indexFile =
+		indexFile_.empty() ? defaultIndexFileName(rawlogFile) : indexFile_;
+
+	CFileGZInputStream fi;
+	if (!mrpt::system::fileExists(rawlogFile) || !fi.open(rawlogFile))
+		return false;
+	auto arch = archiveFrom(fi);
+
+	std::vector<TEntry> entries;
+	std::vector<std::string> strings(1);  // [0]: empty string
+	std::map<std::string, uint32_t> stringIdx;
+	stringIdx[std::string()] = 0;
+	const auto internString = [&](const std::string& s) {
+		auto it = stringIdx.find(s);
+		if (it != stringIdx.end()) return it->second;
+		const auto idx = static_cast<uint32_t>(strings.size());
+		strings.push_back(s);
+		stringIdx[s] = idx;
+		return idx;
+	};
+
+	std::string sensorLabel;
+	for (;;)
+	{
+		TEntry e;
+		std::memset(&e, 0, sizeof(e));
+		e.offset = fi.getPosition();
+		CSerializable::Ptr obj;
+		try
+		{
+			obj = arch.ReadObject();
+		}
+		catch (CExceptionEOF&)
+		{
+			break;
+		}
+		catch (std::exception& ex)
+		{
+			// Same behavior than CRawlog::loadFromRawLogFile(): keep all the
+			// entries read so far
+			std::cerr << "[CRawlogIndex::build] Stopping at entry #"
+					  << entries.size() << ": " << ex.what() << std::endl;
+			break;
+		}
+		if (!obj) break;
+		getEntryMetadata(obj, e, sensorLabel);
+		e.classNameIdx = internString(obj->GetRuntimeClass()->className);
+		e.sensorLabelIdx = internString(sensorLabel);
+		entries.push_back(e);
+
+		if (progress && (entries.size() % 1000) == 0)
+			progress(entries.size(), e.offset);
+	}
+	if (progress) progress(entries.size(), fi.getPosition());
+	fi.close();
+
+	// Entries with a valid timestamp, sorted by time:
+	std::vector<uint64_t> sorted;
+	sorted.reserve(entries.size());
+	for (size_t i = 0; i < entries.size(); i++)
+		if (entries[i].timestamp != INVALID_TIMESTAMP) sorted.push_back(i);
+	std::stable_sort(
+		sorted.begin(), sorted.end(), [&entries](uint64_t a, uint64_t b) {
+			return entries[a].timestamp < entries[b].timestamp;
+		});
+
+	TFileHeader hdr;
+	std::memset(&hdr, 0, sizeof(hdr));
+	std::memcpy(hdr.magic, RAWLOG_INDEX_MAGIC, sizeof(hdr.magic));
+	hdr.version = FILE_VERSION;
+	hdr.headerSize = sizeof(TFileHeader);
+	hdr.numEntries = entries.size();
+	hdr.numSorted = sorted.size();
+	hdr.numStrings = strings.size();
+	hdr.sortedOffset = sizeof(TFileHeader) + sizeof(TEntry) * entries.size();
+	hdr.stringsOffset = hdr.sortedOffset + sizeof(uint64_t) * sorted.size();
+	hdr.rawlogFileSize = mrpt::system::getFileSize(rawlogFile);
+	hdr.rawlogModifTime = mrpt::system::getFileModificationTime(rawlogFile);
+
+	try
+	{
+		CFileOutputStream fo;
+		if (!fo.open(indexFile)) return false;
+		fo.Write(&hdr, sizeof(hdr));
+		if (!entries.empty())
+			fo.Write(entries.data(), sizeof(TEntry) * entries.size());
+		if (!sorted.empty())
+			fo.Write(sorted.data(), sizeof(uint64_t) * sorted.size());
+		for (const auto& s : strings)
+		{
+			const auto len = static_cast<uint32_t>(s.size());
+			fo.Write(&len, sizeof(len));
+			if (len) fo.Write(s.data(), len);
+		}
+	}
+	catch (std::exception& ex)
+	{
+		std::cerr << "[CRawlogIndex::build] Error writing '" << indexFile
+				  << "': " << ex.what() << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool CRawlogIndex::open(const std::string& indexFile)
+{
+	close();
+	if (!mrpt::system::fileExists(indexFile) || !m_file.open(indexFile))
+		return false;
+
+	const uint8_t* data = m_file.data();
+	const size_t len = m_file.size();
+	if (len < sizeof(TFileHeader))
+	{
+		close();
+		return false;
+	}
+	const auto* hdr = reinterpret_cast<const TFileHeader*>(data);
+	if (std::memcmp(hdr->magic, RAWLOG_INDEX_MAGIC, sizeof(hdr->magic)) ||
+		hdr->version != FILE_VERSION || hdr->headerSize != sizeof(TFileHeader) ||
+		hdr->sortedOffset !=
+			sizeof(TFileHeader) + sizeof(TEntry) * hdr->numEntries ||
+		hdr->stringsOffset !=
+			hdr->sortedOffset + sizeof(uint64_t) * hdr->numSorted ||
+		hdr->stringsOffset > len || hdr->numSorted > hdr->numEntries)
+	{
+		close();
+		return false;
+	}
+
+	// Parse the string table:
+	m_strings.resize(hdr->numStrings);
+	size_t pos = hdr->stringsOffset;
+	for (auto& s : m_strings)
+	{
+		uint32_t slen;
+		if (pos + sizeof(slen) > len)
+		{
+			close();
+			return false;
+		}
+		std::memcpy(&slen, data + pos, sizeof(slen));
+		pos += sizeof(slen);
+		if (pos + slen > len)
+		{
+			close();
+			return false;
+		}
+		s.assign(reinterpret_cast<const char*>(data + pos), slen);
+		pos += slen;
+	}
+	if (m_strings.empty()) m_strings.resize(1);
+
+	m_header = hdr;
+	m_entries = reinterpret_cast<const TEntry*>(data + sizeof(TFileHeader));
+	m_sorted = reinterpret_cast<const uint64_t*>(data + hdr->sortedOffset);
+	return true;
+}
+
+void CRawlogIndex::close()
+{
+	m_header = nullptr;
+	m_entries = nullptr;
+	m_sorted = nullptr;
+	m_strings.clear();
+	m_file.close();
+}
+
+bool CRawlogIndex::isUpToDateWith(const std::string& rawlogFile) const
+{
+	return m_header && mrpt::system::fileExists(rawlogFile) &&
+		   m_header->rawlogFileSize == mrpt::system::getFileSize(rawlogFile) &&
+		   m_header->rawlogModifTime ==
+			   static_cast<int64_t>(
+				   mrpt::system::getFileModificationTime(rawlogFile));
+}
+
+const std::string& CRawlogIndex::className(size_t i) const
+{
+	const auto idx = m_entries[i].classNameIdx;
+	return idx < m_strings.size() ? m_strings[idx] : m_strings[0];
+}
+
+const std::string& CRawlogIndex::sensorLabel(size_t i) const
+{
+	const auto idx = m_entries[i].sensorLabelIdx;
+	return idx < m_strings.size() ? m_strings[idx] : m_strings[0];
+}
+
+size_t CRawlogIndex::lowerBoundByTime(mrpt::system::TTimeStamp t) const
+{
+	const uint64_t* first = m_sorted;
+	const uint64_t* last = m_sorted + sortedByTimeSize();
+	const auto it =
+		std::lower_bound(first, last, t, [this](uint64_t idx, TTimeStamp v) {
+			return m_entries[idx].timestamp < v;
+		});
+	return it - first;
+}
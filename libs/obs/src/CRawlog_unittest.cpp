@@ -0,0 +1,202 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/obs/CRawlog.h>
+#include <mrpt/obs/CRawlogIndex.h>
+#include <mrpt/obs/CObservationOdometry.h>
+#include <mrpt/obs/CObservation2DRangeScan.h>
+#include <mrpt/io/CFileOutputStream.h>
+#include <mrpt/serialization/CArchive.h>
+#include <mrpt/system/filesystem.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::obs;
+using namespace std;
+
+namespace
+{
+// A rawlog with odometry and range scans, with increasing timestamps:
+void makeRawlog(CRawlog& rawlog, size_t N)
+{
+	rawlog.clear();
+	rawlog.setCommentText("Test rawlog\n[params]\nfoo=1\n");
+	for (size_t i = 0; i < N; i++)
+	{
+		const auto t = mrpt::system::time_tToTimestamp(1e9 + 0.1 * i);
+		if (i % 3 == 0)
+		{
+			auto obs = mrpt::make_aligned_shared<CObservation2DRangeScan>();
+			obs->timestamp = t;
+			obs->sensorLabel = "LASER";
+			obs->resizeScan(10);
+			for (size_t k = 0; k < 10; k++)
+				obs->setScanRange(k, 0.1f * (i + k));
+			rawlog.addObservationMemoryReference(obs);
+		}
+		else
+		{
+			auto obs = mrpt::make_aligned_shared<CObservationOdometry>();
+			obs->timestamp = t;
+			obs->sensorLabel = "ODOMETRY";
+			obs->odometry = mrpt::poses::CPose2D(0.5 * i, 0, 0);
+			rawlog.addObservationMemoryReference(obs);
+		}
+	}
+}
+
+void checkSameContents(const CRawlog& a, const CRawlog& b)
+{
+	ASSERT_EQ(a.size(), b.size());
+	EXPECT_EQ(a.getCommentText(), b.getCommentText());
+	// Random access order, going backwards and forwards:
+	for (size_t j = 0; j < a.size(); j++)
+	{
+		const size_t i = (j * 7) % a.size();
+		EXPECT_EQ(a.getType(i), b.getType(i));
+		const auto oa = a.getAsObservation(i);
+		const auto ob = b.getAsObservation(i);
+		EXPECT_EQ(oa->GetRuntimeClass(), ob->GetRuntimeClass());
+		EXPECT_EQ(oa->timestamp, ob->timestamp);
+		EXPECT_EQ(oa->sensorLabel, ob->sensorLabel);
+		if (IS_CLASS(oa, CObservationOdometry))
+			EXPECT_EQ(
+				std::dynamic_pointer_cast<CObservationOdometry>(oa)->odometry,
+				std::dynamic_pointer_cast<CObservationOdometry>(ob)->odometry);
+		else
+			EXPECT_EQ(
+				std::dynamic_pointer_cast<CObservation2DRangeScan>(oa)
+					->getScanRange(9),
+				std::dynamic_pointer_cast<CObservation2DRangeScan>(ob)
+					->getScanRange(9));
+	}
+}
+
+void testLazyRawlog(const std::string& fil)
+{
+	CRawlog ref;
+	ASSERT_TRUE(ref.loadFromRawLogFile(fil));
+	ASSERT_EQ(ref.size(), 100u);
+
+	const std::string idxFile = CRawlogIndex::defaultIndexFileName(fil);
+	mrpt::system::deleteFile(idxFile);
+
+	CRawlog lazy;
+	ASSERT_TRUE(lazy.loadFromRawLogFileLazy(fil));
+	EXPECT_TRUE(lazy.isLazy());
+	EXPECT_TRUE(mrpt::system::fileExists(idxFile));
+	lazy.setLazyCacheSize(5);
+	checkSameContents(ref, lazy);
+	EXPECT_TRUE(lazy.isLazy());
+
+	// Index metadata:
+	{
+		CRawlogIndex idx;
+		ASSERT_TRUE(idx.open(idxFile));
+		EXPECT_TRUE(idx.isUpToDateWith(fil));
+		ASSERT_EQ(idx.size(), ref.size() + 1);  // +1: comments
+		EXPECT_EQ(idx.kind(0), CRawlogIndex::ekComment);
+		EXPECT_EQ(idx.className(1), "CObservation2DRangeScan");
+		EXPECT_EQ(idx.sensorLabel(1), "LASER");
+		EXPECT_EQ(idx.sensorLabel(2), "ODOMETRY");
+		EXPECT_EQ(idx.timestamp(5), ref.getAsObservation(4)->timestamp);
+		EXPECT_EQ(idx.sortedByTimeSize(), ref.size());
+		const auto t = ref.getAsObservation(50)->timestamp;
+		const size_t k = idx.lowerBoundByTime(t);
+		ASSERT_LT(k, idx.sortedByTimeSize());
+		EXPECT_EQ(idx.sortedByTime(k), 51u);
+		EXPECT_EQ(idx.lowerBoundByTime(t + 1), k + 1);
+	}
+
+	// Timestamp queries:
+	{
+		const auto t0 = ref.getAsObservation(10)->timestamp;
+		const auto t1 = ref.getAsObservation(40)->timestamp;
+		TListTimeAndObservations found_ref, found_lazy;
+		ref.findObservationsByClassInRange(
+			t0, t1, CLASS_ID(CObservationOdometry), found_ref);
+		lazy.findObservationsByClassInRange(
+			t0, t1, CLASS_ID(CObservationOdometry), found_lazy);
+		EXPECT_EQ(found_ref.size(), 20u);
+		ASSERT_EQ(found_ref.size(), found_lazy.size());
+		for (auto ita = found_ref.begin(), itb = found_lazy.begin();
+			 ita != found_ref.end(); ++ita, ++itb)
+		{
+			EXPECT_EQ(ita->first, itb->first);
+			EXPECT_EQ(ita->second->sensorLabel, itb->second->sensorLabel);
+		}
+	}
+
+	// Copies share the backend:
+	{
+		CRawlog copy = lazy;
+		EXPECT_TRUE(copy.isLazy());
+		checkSameContents(ref, copy);
+	}
+
+	// Modifying loads everything:
+	lazy.remove(0);
+	EXPECT_FALSE(lazy.isLazy());
+	EXPECT_EQ(lazy.size(), ref.size() - 1);
+	ref.remove(0);
+	checkSameContents(ref, lazy);
+
+	mrpt::system::deleteFile(idxFile);
+}
+}  // namespace
+
+TEST(CRawlog, lazyLoadCompressed)
+{
+	CRawlog rawlog;
+	makeRawlog(rawlog, 100);
+	const std::string fil = mrpt::system::getTempFileName() + ".rawlog";
+	ASSERT_TRUE(rawlog.saveToRawLogFile(fil));
+	testLazyRawlog(fil);
+	mrpt::system::deleteFile(fil);
+}
+
+TEST(CRawlog, lazyLoadUncompressed)
+{
+	CRawlog rawlog;
+	makeRawlog(rawlog, 100);
+	const std::string fil = mrpt::system::getTempFileName() + ".rawlog";
+	{
+		mrpt::io::CFileOutputStream fo(fil);
+		auto f = mrpt::serialization::archiveFrom(fo);
+		CObservationComment comments;
+		comments.text = rawlog.getCommentText();
+		f << comments;
+		for (size_t i = 0; i < rawlog.size(); i++)
+			f << *rawlog.getAsGeneric(i);
+	}
+	testLazyRawlog(fil);
+	mrpt::system::deleteFile(fil);
+}
+
+TEST(CRawlog, lazyIndexRebuiltIfOutdated)
+{
+	CRawlog rawlog;
+	makeRawlog(rawlog, 100);
+	const std::string fil = mrpt::system::getTempFileName() + ".rawlog";
+	ASSERT_TRUE(rawlog.saveToRawLogFile(fil));
+	const std::string idxFile = CRawlogIndex::defaultIndexFileName(fil);
+	ASSERT_TRUE(CRawlogIndex::build(fil));
+
+	// Overwrite the rawlog with fewer entries:
+	makeRawlog(rawlog, 40);
+	ASSERT_TRUE(rawlog.saveToRawLogFile(fil));
+
+	CRawlog lazy;
+	EXPECT_FALSE(lazy.loadFromRawLogFileLazy(fil, false, false));
+	ASSERT_TRUE(lazy.loadFromRawLogFileLazy(fil));
+	EXPECT_EQ(lazy.size(), 40u);
+
+	mrpt::system::deleteFile(fil);
+	mrpt::system::deleteFile(idxFile);
+}
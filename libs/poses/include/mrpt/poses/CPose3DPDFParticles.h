@@ -16,6 +16,10 @@
 
 namespace mrpt
 {
+namespace random
+{
+class CRandomGenerator;
+}
 namespace poses
 {
 /** Declares a class that represents a Probability Density function (PDF) of a
@@ -82,6 +86,10 @@ class CPose3DPDFParticles
 	/** Draws a single sample from the distribution (WARNING: weights are
 	 * assumed to be normalized!) */
 	void drawSingleSample(CPose3D& outPart) const override;
+	/** \overload Draws the sample from the given random generator instead of
+	 * the global one, e.g. to sample from different threads. */
+	void drawSingleSample(
+		CPose3D& outPart, mrpt::random::CRandomGenerator& rng) const;
 	/** Draws a number of samples from the distribution, and saves as a list of
 	 * 1x6 vectors, where each row contains a (x,y,phi) datum. */
 	void drawManySamples(
@@ -16,6 +16,10 @@
 
 namespace mrpt
 {
+namespace random
+{
+class CRandomGenerator;
+}
 namespace poses
 {
 /** Declares a class that represents a Probability Density Function (PDF) over a
@@ -130,6 +134,10 @@ class CPosePDFParticles
 	 * assumed to be normalized!)
 	  */
 	void drawSingleSample(CPose2D& outPart) const override;
+	/** \overload Draws the sample from the given random generator instead of
+	 * the global one, e.g. to sample from different threads. */
+	void drawSingleSample(
+		CPose2D& outPart, mrpt::random::CRandomGenerator& rng) const;
 
 	/** Appends (pose-composition) a given pose "p" to each particle
 	  */
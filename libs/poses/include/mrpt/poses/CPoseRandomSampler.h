@@ -17,6 +17,14 @@
 #include <mrpt/math/math_frwds.h>
 #include <memory>  // unique_ptr
 
+namespace mrpt
+{
+namespace random
+{
+class CRandomGenerator;
+}
+}
+
 namespace mrpt
 {
 namespace poses
@@ -60,9 +68,9 @@ class CPoseRandomSampler
 	void clear();
 
 	/** Used internally: sample from m_pdf2D */
-	void do_sample_2D(CPose2D& p) const;
+	void do_sample_2D(CPose2D& p, mrpt::random::CRandomGenerator& rng) const;
 	/** Used internally: sample from m_pdf3D */
-	void do_sample_3D(CPose3D& p) const;
+	void do_sample_3D(CPose3D& p, mrpt::random::CRandomGenerator& rng) const;
 
    public:
 	/** Default constructor */
@@ -113,6 +121,18 @@ class CPoseRandomSampler
 	  */
 	CPose3D& drawSample(CPose3D& p) const;
 
+	/** Like drawSample(), but drawing the random numbers from the given
+	 * generator instead of the global mrpt::random::getRandomGenerator().
+	 * Useful to draw samples from several threads in parallel, each one
+	 * with its own generator. Both Gaussian and particle-based PDFs are
+	 * sampled from `rng` only.
+	 * \sa setPosePDF
+	 */
+	CPose2D& drawSample(CPose2D& p, mrpt::random::CRandomGenerator& rng) const;
+
+	/** \overload */
+	CPose3D& drawSample(CPose3D& p, mrpt::random::CRandomGenerator& rng) const;
+
 	/** Return true if samples can be generated, which only requires a previous
 	 * call to setPosePDF */
 	bool isPrepared() const;
@@ -16,6 +16,7 @@
 #include <mrpt/serialization/CArchive.h>
 #include <mrpt/poses/SO_SE_average.h>
 #include <mrpt/system/os.h>
+#include <mrpt/random.h>
 
 using namespace mrpt;
 using namespace mrpt::poses;
@@ -277,8 +278,28 @@ void CPose3DPDFParticles::changeCoordinatesReference(
  ---------------------------------------------------------------*/
 void CPose3DPDFParticles::drawSingleSample(CPose3D& outPart) const
 {
-	MRPT_UNUSED_PARAM(outPart);
-	THROW_EXCEPTION("TO DO!");
+	drawSingleSample(outPart, mrpt::random::getRandomGenerator());
+}
+
+void CPose3DPDFParticles::drawSingleSample(
+	CPose3D& outPart, mrpt::random::CRandomGenerator& rng) const
+{
+	ASSERT_(!m_particles.empty());
+	const double uni = rng.drawUniform(0.0, 0.9999);
+	double cum = 0;
+
+	for (const auto& p : m_particles)
+	{
+		cum += exp(p.log_w);
+		if (uni <= cum)
+		{
+			outPart = *p.d;
+			return;
+		}
+	}
+
+	// Might not come here normally:
+	outPart = *m_particles.rbegin()->d;
 }
 
 /*---------------------------------------------------------------
@@ -331,7 +331,13 @@ void CPosePDFParticles::changeCoordinatesReference(
  ---------------------------------------------------------------*/
 void CPosePDFParticles::drawSingleSample(CPose2D& outPart) const
 {
-	const double uni = getRandomGenerator().drawUniform(0.0, 0.9999);
+	drawSingleSample(outPart, getRandomGenerator());
+}
+
+void CPosePDFParticles::drawSingleSample(
+	CPose2D& outPart, CRandomGenerator& rng) const
+{
+	const double uni = rng.drawUniform(0.0, 0.9999);
 	double cum = 0;
 
 	for (CParticleList::const_iterator it = m_particles.begin();
@@ -23,6 +23,9 @@ CRandomGenerator& mrpt::random::getRandomGenerator() { return randomGenerator; }
 void CRandomGenerator::MT19937_initializeGenerator(const uint32_t& seed)
 {
 	m_MT19937.seed(seed);
+	// Discard any Gaussian sample cached by the distribution object, so the
+	// sequence only depends on the seed:
+	m_normdistribution.reset();
 }
 
 uint64_t CRandomGenerator::drawUniform64bit() { return m_uint64(m_MT19937); }
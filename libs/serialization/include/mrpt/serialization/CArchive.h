@@ -16,6 +16,7 @@
 #include <vector>
 #include <string>
 #include <type_traits>  // remove_reference_t
+#include <cstring>
 #include <stdexcept>
 #include <mrpt/rtti/variant.h>
 
@@ -94,6 +95,67 @@ class CArchive
 #endif
 	}
 
+	/** Zero-copy read: returns a pointer to the next \a Count bytes of the
+	 * stream, directly in the memory of memory-backed streams (e.g.
+	 * mrpt::io::CMemoryStream, including those assigned to a memory-mapped
+	 * file, or `std::vector<uint8_t>`), and advances the read position.
+	 * The returned memory belongs to the stream: it is valid while the
+	 * stream is not modified or destroyed and it has no particular
+	 * alignment, so it should be accessed via `memcpy()`.
+	 * \return nullptr, without reading anything, if the stream does not
+	 * support in-place reads or does not have \a Count bytes left: use
+	 * ReadBuffer() in that case.
+	 * \sa ReadBufferFixEndiannessAssign
+	 */
+	const void* ReadBufferInPlace(size_t Count)
+	{
+		return Count ? this->readInPlace(Count) : nullptr;
+	}
+
+	/** Bulk read of \a ElementCount elemental values into a contiguous
+	 * container (`std::vector<>`, aligned vectors,...), which is resized
+	 * accordingly. Equivalent to:
+	 *  \code
+	 *   v.resize(N);
+	 *   s.ReadBufferFixEndianness(&v[0], N);
+	 *  \endcode
+	 * but, for memory-backed streams (see ReadBufferInPlace()), the elements
+	 * are copied exactly once from the stream memory, without the
+	 * value-initialization of `resize()`.
+	 *	\exception std::exception On any error, or if there are not enough
+	 * bytes in the stream.
+	 */
+	template <class VECTOR>
+	void ReadBufferFixEndiannessAssign(VECTOR& v, size_t ElementCount)
+	{
+		using T = typename VECTOR::value_type;
+		static_assert(
+			std::is_trivially_copyable<T>::value,
+			"Only for arrays of elemental types");
+		const auto* p = static_cast<const uint8_t*>(
+			ReadBufferInPlace(ElementCount * sizeof(T)));
+		if (p && reinterpret_cast<std::uintptr_t>(p) % alignof(T) == 0)
+		{
+			const T* first = reinterpret_cast<const T*>(p);
+			v.assign(first, first + ElementCount);
+		}
+		else
+		{
+			v.resize(ElementCount);
+			if (!ElementCount) return;
+			if (p)
+				::memcpy(&v[0], p, ElementCount * sizeof(T));
+			else if (ReadBuffer(&v[0], ElementCount * sizeof(T)) !=
+					 ElementCount * sizeof(T))
+				throw CExceptionEOF(
+					"ReadBufferFixEndiannessAssign: Unexpected EOF");
+		}
+#if MRPT_IS_BIG_ENDIAN
+		for (size_t i = 0; i < ElementCount; i++)
+			mrpt::reverseBytesInPlace(v[i]);
+#endif
+	}
+
 	/** Writes a block of bytes to the stream from Buffer.
 	 *	\exception std::exception On any error
 	 *  \sa Important, see: WriteBufferFixEndianness
@@ -362,6 +424,11 @@ class CArchive
 	 * \return Number of bytes actually read if >0.
 	 */
 	virtual size_t read(void* buf, size_t len) = 0;
+	/** Returns a pointer to the next \a len bytes in the memory of the
+	 * underlying stream and skips them, or nullptr if not supported (the
+	 * default) or if there are not enough bytes left.
+	 * \sa ReadBufferInPlace */
+	virtual const void* readInPlace(size_t /*len*/) { return nullptr; }
 	/** @} */
 
 	/** Read the object */
@@ -485,11 +552,28 @@ class CArchiveStreamBase : public CArchive
 {
 	STREAM& m_s;
 
+	// In-place reads, for streams providing `ReadInPlace()`:
+	template <class S>
+	static auto readInPlaceImpl(S& s, size_t n, int)
+		-> decltype(s.ReadInPlace(n))
+	{
+		return s.ReadInPlace(n);
+	}
+	template <class S>
+	static const void* readInPlaceImpl(S&, size_t, long)
+	{
+		return nullptr;
+	}
+
    public:
 	CArchiveStreamBase(STREAM& s) : m_s(s) {}
    protected:
 	size_t write(const void* d, size_t n) override { return m_s.Write(d, n); }
 	size_t read(void* d, size_t n) override { return m_s.Read(d, n); }
+	const void* readInPlace(size_t n) override
+	{
+		return readInPlaceImpl(m_s, n, 0);
+	}
 };
 
 /** Helper function to create a templatized wrapper CArchive object for a:
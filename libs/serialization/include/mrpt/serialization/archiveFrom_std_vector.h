@@ -48,6 +48,14 @@ class CArchiveStreamBase<std::vector<uint8_t>> : public CArchive
 		m_pos_read += n;
 		return n;
 	};
+	const void* readInPlace(size_t n) override
+	{
+		const int avail = static_cast<int>(m_v.size()) - m_pos_read;
+		if (avail < static_cast<int>(n)) return nullptr;
+		const void* p = &m_v[m_pos_read];
+		m_pos_read += n;
+		return p;
+	}
 };
 /** Read-only version of the wrapper. See archiveFrom() */
 template <>
@@ -74,6 +82,14 @@ class CArchiveStreamBase<const std::vector<uint8_t>> : public CArchive
 		m_pos_read += n;
 		return n;
 	};
+	const void* readInPlace(size_t n) override
+	{
+		const int avail = static_cast<int>(m_v.size()) - m_pos_read;
+		if (avail < static_cast<int>(n)) return nullptr;
+		const void* p = &m_v[m_pos_read];
+		m_pos_read += n;
+		return p;
+	}
 };
 }  // namespace serialization
 }  // namespace mrpt
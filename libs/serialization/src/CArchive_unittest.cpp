@@ -0,0 +1,107 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/serialization/CArchive.h>
+#include <mrpt/serialization/archiveFrom_std_streams.h>
+#include <mrpt/serialization/archiveFrom_std_vector.h>
+#include <mrpt/io/CMemoryStream.h>
+#include <gtest/gtest.h>
+#include <sstream>
+
+using namespace mrpt::serialization;
+
+namespace
+{
+std::vector<float> testData(size_t N)
+{
+	std::vector<float> v(N);
+	for (size_t i = 0; i < N; i++) v[i] = 0.5f * i - 3.0f;
+	return v;
+}
+
+// Writes `nPrefix` bytes, then the array, and reads it back:
+template <class ARCHIVE>
+void writeArray(ARCHIVE& arch, const std::vector<float>& v, size_t nPrefix)
+{
+	for (size_t i = 0; i < nPrefix; i++) arch << uint8_t(i);
+	arch.WriteBufferFixEndianness(&v[0], v.size());
+	arch << uint32_t(0xCAFE);
+}
+template <class ARCHIVE>
+void readArrayAndCheck(
+	ARCHIVE& arch, const std::vector<float>& v, size_t nPrefix)
+{
+	for (size_t i = 0; i < nPrefix; i++)
+		EXPECT_EQ(arch.template ReadAs<uint8_t>(), i);
+	std::vector<float> r{1.0f};
+	arch.ReadBufferFixEndiannessAssign(r, v.size());
+	EXPECT_EQ(r, v);
+	EXPECT_EQ(arch.template ReadAs<uint32_t>(), 0xCAFEu);
+}
+}  // namespace
+
+TEST(CArchive, ReadBufferInPlace)
+{
+	mrpt::io::CMemoryStream f;
+	auto arch = archiveFrom(f);
+	arch << uint32_t(1) << uint32_t(2);
+	f.Seek(0);
+	const void* p = arch.ReadBufferInPlace(sizeof(uint32_t));
+	ASSERT_TRUE(p != nullptr);
+	EXPECT_EQ(p, f.getRawBufferData());
+	EXPECT_EQ(arch.ReadAs<uint32_t>(), 2u);
+	EXPECT_EQ(f.getPosition(), 2 * sizeof(uint32_t));
+
+	// Not enough data: nothing is consumed.
+	mrpt::io::CMemoryStream g;
+	g.assignMemoryNotOwn(f.getRawBufferData(), 2 * sizeof(uint32_t));
+	auto arch2 = archiveFrom(g);
+	EXPECT_TRUE(arch2.ReadBufferInPlace(3 * sizeof(uint32_t)) == nullptr);
+	EXPECT_EQ(g.getPosition(), 0u);
+	EXPECT_EQ(arch2.ReadAs<uint32_t>(), 1u);
+}
+
+TEST(CArchive, ReadBufferFixEndiannessAssign_CMemoryStream)
+{
+	const auto v = testData(1000);
+	// Both aligned and misaligned arrays in the stream memory:
+	for (size_t nPrefix = 0; nPrefix < 4; nPrefix++)
+	{
+		mrpt::io::CMemoryStream f;
+		auto arch = archiveFrom(f);
+		writeArray(arch, v, nPrefix);
+		f.Seek(0);
+		readArrayAndCheck(arch, v, nPrefix);
+	}
+}
+
+TEST(CArchive, ReadBufferFixEndiannessAssign_stdvector)
+{
+	const auto v = testData(100);
+	std::vector<uint8_t> buf;
+	auto arch = archiveFrom(buf);
+	writeArray(arch, v, 1);
+	const std::vector<uint8_t>& cbuf = buf;
+	auto arch_ro = archiveFrom(cbuf);
+	readArrayAndCheck(arch_ro, v, 1);
+}
+
+TEST(CArchive, ReadBufferFixEndiannessAssign_noInPlace)
+{
+	// std::iostream does not support in-place reads:
+	const auto v = testData(100);
+	std::stringstream ss;
+	auto arch = archiveFrom<std::iostream>(ss);
+	writeArray(arch, v, 1);
+	EXPECT_TRUE(arch.ReadBufferInPlace(4) == nullptr);
+	readArrayAndCheck(arch, v, 1);
+
+	std::vector<float> r;
+	EXPECT_THROW(arch.ReadBufferFixEndiannessAssign(r, 10), std::exception);
+}
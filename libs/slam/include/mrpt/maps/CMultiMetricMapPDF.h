@@ -274,6 +274,10 @@ class CMultiMetricMapPDF
 		const size_t particleIndexForMap,
 		const mrpt::obs::CSensoryFrame& observation,
 		const mrpt::poses::CPose3D& x) const override;
+	/** Always true: each particle has its own map, which is only accessed by
+	 * the thread evaluating that particle. */
+	bool PF_SLAM_implementation_prepareConcurrentLikelihood(
+		const mrpt::obs::CSensoryFrame& observation) const override;
 	/** @} */
 
 };  // End of class def.
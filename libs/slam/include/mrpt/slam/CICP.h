@@ -179,6 +179,13 @@ class CICP : public mrpt::slam::CMetricMapsAlignmentAlgorithm
 		 * queries,
 		 *  the most expensive step in ICP */
 		uint32_t corresponding_points_decimation;
+
+		/** Number of threads for the search of correspondences, usually the
+		 * most expensive step in ICP with large point clouds: 1 means no
+		 * parallelization, 0 one thread per core (default=1). Results do not
+		 * depend on this value. \sa mrpt::maps::TMatchingParams::numThreads
+		 */
+		uint32_t numThreads;
 	};
 
 	/** The options employed by the ICP align. */
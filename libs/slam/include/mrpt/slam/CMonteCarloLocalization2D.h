@@ -157,6 +157,18 @@ class CMonteCarloLocalization2D
 		const size_t particleIndexForMap,
 		const mrpt::obs::CSensoryFrame& observation,
 		const mrpt::poses::CPose3D& x) const override;
+	/** Supports the maps listed in
+	 * TMonteCarloLocalizationParams::prepareMapsForConcurrentLikelihood() */
+	bool PF_SLAM_implementation_prepareConcurrentLikelihood(
+		const mrpt::obs::CSensoryFrame& observation) const override;
+	/** Uses COccupancyGridMap2D::computeObservationLikelihoodBatch() if
+	 * TMonteCarloLocalizationParams::metricMap is an occupancy grid map */
+	bool PF_SLAM_computeObservationLikelihoodForParticles(
+		const mrpt::bayes::CParticleFilter::TParticleFilterOptions& PF_options,
+		const size_t firstParticleIndex,
+		const mrpt::obs::CSensoryFrame& observation,
+		const std::vector<mrpt::math::TPose3D>& x,
+		std::vector<double>& out_logLiks) const override;
 	/** @} */
 
 };  // End of class def.
@@ -118,6 +118,10 @@ class CMonteCarloLocalization3D
 		const size_t particleIndexForMap,
 		const mrpt::obs::CSensoryFrame& observation,
 		const mrpt::poses::CPose3D& x) const;
+	/** Supports the maps listed in
+	 * TMonteCarloLocalizationParams::prepareMapsForConcurrentLikelihood() */
+	bool PF_SLAM_implementation_prepareConcurrentLikelihood(
+		const mrpt::obs::CSensoryFrame& observation) const;
 	/** @} */
 
 };  // End of class def.
@@ -32,6 +32,83 @@ namespace mrpt
 {
 namespace slam
 {
+/** Auxiliary method called by PF implementations to process a range of
+ * particles in parallel. See declaration for docs.
+ *   \ingroup mrpt_slam_grp
+ */
+template <class PARTICLE_TYPE, class MYSELF>
+template <class FUNCTOR>
+void PF_implementation<PARTICLE_TYPE, MYSELF>::
+	PF_SLAM_implementation_parallel_for(
+		const unsigned int numThreads, const size_t first, const size_t last,
+		FUNCTOR&& func, const size_t blockSize) const
+{
+	MRPT_START
+	if (first >= last) return;
+
+	if (numThreads == 1)
+	{
+		// Sequential processing, with the global random generator:
+		auto& rng = mrpt::random::getRandomGenerator();
+		for (size_t i = first; i < last; i++) func(i, rng);
+		return;
+	}
+
+	// One independent random generator per block of particles:
+	ASSERT_(blockSize > 0);
+	const size_t nBlocks = (last - first + blockSize - 1) / blockSize;
+	std::vector<mrpt::random::CRandomGenerator> rngs;
+	rngs.reserve(nBlocks);
+	for (size_t b = 0; b < nBlocks; b++)
+		rngs.emplace_back(
+			mrpt::random::getRandomGenerator().drawUniform32bit());
+
+	const size_t nThreads =
+		numThreads != 0
+			? numThreads
+			: std::max<size_t>(1, std::thread::hardware_concurrency());
+	if (!m_threadsPool || m_threadsPool->size() != nThreads)
+		m_threadsPool =
+			std::make_shared<mrpt::system::CWorkerThreadsPool>(nThreads);
+
+	// Evaluate the first item in this thread, to warm-up any lazy cache:
+	func(first, rngs[0]);
+
+	std::vector<std::future<void>> futs;
+	futs.reserve(nBlocks);
+	for (size_t b = 0; b < nBlocks; b++)
+	{
+		const size_t i0 = (b == 0) ? first + 1 : first + b * blockSize;
+		const size_t i1 = std::min(last, first + (b + 1) * blockSize);
+		auto& rng = rngs[b];
+		futs.emplace_back(m_threadsPool->enqueue([&func, &rng, i0, i1]() {
+			for (size_t i = i0; i < i1; i++) func(i, rng);
+		}));
+	}
+	// Wait for all tasks before re-throwing any exception, since they refer
+	// to local variables:
+	for (auto& f : futs) f.wait();
+	for (auto& f : futs) f.get();
+	MRPT_END
+}
+
+template <class PARTICLE_TYPE, class MYSELF>
+unsigned int PF_implementation<PARTICLE_TYPE, MYSELF>::
+	PF_SLAM_implementation_numThreads(
+		const mrpt::bayes::CParticleFilter::TParticleFilterOptions& PF_options,
+		const mrpt::obs::CSensoryFrame* sf) const
+{
+	if (PF_options.numThreads == 1) return 1;
+	if (sf && !PF_SLAM_implementation_prepareConcurrentLikelihood(*sf))
+	{
+		MRPT_LOG_DEBUG(
+			"Evaluating observation likelihoods sequentially: the map does "
+			"not support concurrent evaluation.");
+		return 1;
+	}
+	return PF_options.numThreads;
+}
+
 /** Auxiliary method called by PF implementations: return true if we have both
  * action & observation,
  *   otherwise, return false AND accumulate the odometry so when we have an
@@ -236,22 +313,23 @@ void PF_implementation<PARTICLE_TYPE, MYSELF>::
 			// -------------------------------------------------------------
 			// FIXED SAMPLE SIZE
 			// -------------------------------------------------------------
-			mrpt::poses::CPose3D incrPose;
-			for (size_t i = 0; i < M; i++)
-			{
-				// Generate gaussian-distributed 2D-pose increments according to
-				// mean-cov:
-				m_movementDrawer.drawSample(incrPose);
-				bool pose_is_valid;
-				const mrpt::poses::CPose3D finalPose =
-					mrpt::poses::CPose3D(getLastPose(i, pose_is_valid)) +
-					incrPose;
-
-				// Update the particle with the new pose: this part is
-				// caller-dependant and must be implemented there:
-				PF_SLAM_implementation_custom_update_particle_with_new_pose(
-					me->m_particles[i].d.get(), finalPose.asTPose());
-			}
+			this->PF_SLAM_implementation_parallel_for(
+				PF_SLAM_implementation_numThreads(PF_options, nullptr), 0, M,
+				[this, me](size_t i, mrpt::random::CRandomGenerator& rng) {
+					// Generate gaussian-distributed 2D-pose increments
+					// according to mean-cov:
+					mrpt::poses::CPose3D incrPose;
+					m_movementDrawer.drawSample(incrPose, rng);
+					bool pose_is_valid;
+					const mrpt::poses::CPose3D finalPose =
+						mrpt::poses::CPose3D(getLastPose(i, pose_is_valid)) +
+						incrPose;
+
+					// Update the particle with the new pose: this part is
+					// caller-dependant and must be implemented there:
+					PF_SLAM_implementation_custom_update_particle_with_new_pose(
+						me->m_particles[i].d.get(), finalPose.asTPose());
+				});
 		}
 		else
 		{
@@ -344,19 +422,60 @@ void PF_implementation<PARTICLE_TYPE, MYSELF>::
 		const size_t M = me->m_particles.size();
 		//	UPDATE STAGE
 		// ----------------------------------------------------------------------
-		// Compute all the likelihood values & update particles weight:
-		for (size_t i = 0; i < M; i++)
+		// Compute all the likelihood values & update particles weight.
+		// Try first with the batch evaluation, in blocks of particles:
+		auto evalBlock = [this, me, sf, &PF_options, M](const size_t block) {
+			const size_t i0 = block * PARALLEL_BLOCK_SIZE;
+			const size_t i1 = std::min(M, i0 + PARALLEL_BLOCK_SIZE);
+			std::vector<mrpt::math::TPose3D> partPoses(i1 - i0);
+			for (size_t i = i0; i < i1; i++)
+			{
+				bool pose_is_valid;
+				partPoses[i - i0] = getLastPose(i, pose_is_valid);
+			}
+			std::vector<double> obs_log_likelihoods;
+			if (!PF_SLAM_computeObservationLikelihoodForParticles(
+					PF_options, i0, *sf, partPoses, obs_log_likelihoods))
+				return false;
+			ASSERT_EQUAL_(obs_log_likelihoods.size(), partPoses.size());
+			for (size_t i = i0; i < i1; i++)
+				me->m_particles[i].log_w +=
+					obs_log_likelihoods[i - i0] * PF_options.powFactor;
+			return true;
+		};
+
+		const unsigned int numThreads =
+			PF_SLAM_implementation_numThreads(PF_options, sf);
+		if (M > 0 && evalBlock(0))
+		{
+			const size_t nBlocks =
+				(M + PARALLEL_BLOCK_SIZE - 1) / PARALLEL_BLOCK_SIZE;
+			this->PF_SLAM_implementation_parallel_for(
+				numThreads, 1, nBlocks,
+				[&evalBlock](size_t block, mrpt::random::CRandomGenerator&) {
+					ASSERT_(evalBlock(block));
+				},
+				1 /* one block of particles per task */);
+		}
+		else
 		{
-			bool pose_is_valid;
-			const mrpt::math::TPose3D partPose =
-				getLastPose(i, pose_is_valid);  // Take the particle data:
-			mrpt::poses::CPose3D partPose2 = mrpt::poses::CPose3D(partPose);
-			const double obs_log_likelihood =
-				PF_SLAM_computeObservationLikelihoodForParticle(
-					PF_options, i, *sf, partPose2);
-			me->m_particles[i].log_w +=
-				obs_log_likelihood * PF_options.powFactor;
-		}  // for each particle "i"
+			this->PF_SLAM_implementation_parallel_for(
+				numThreads, 0, M,
+				[this, me, sf, &PF_options](
+					size_t i, mrpt::random::CRandomGenerator&) {
+					// Take the particle data:
+					bool pose_is_valid;
+					const mrpt::math::TPose3D partPose =
+						getLastPose(i, pose_is_valid);
+					mrpt::poses::CPose3D partPose2 =
+						mrpt::poses::CPose3D(partPose);
+					const double obs_log_likelihood =
+						PF_SLAM_computeObservationLikelihoodForParticle(
+							PF_options, i, *sf, partPose2);
+					me->m_particles[i].log_w +=
+						obs_log_likelihood * PF_options.powFactor;
+				});
+		}
 
 		// Normalization of weights is done outside of this method
 		// automatically.
@@ -405,6 +524,20 @@ double PF_implementation<PARTICLE_TYPE, MYSELF>::
 		const mrpt::bayes::CParticleFilter::TParticleFilterOptions& PF_options,
 		const mrpt::bayes::CParticleFilterCapable* obj, size_t index,
 		const void* action, const void* observation)
+{
+	return PF_SLAM_particlesEvaluator_AuxPFOptimal_rng<BINTYPE>(
+		PF_options, obj, index, action, observation,
+		mrpt::random::getRandomGenerator());
+}
+
+template <class PARTICLE_TYPE, class MYSELF>
+template <class BINTYPE>
+double PF_implementation<PARTICLE_TYPE, MYSELF>::
+	PF_SLAM_particlesEvaluator_AuxPFOptimal_rng(
+		const mrpt::bayes::CParticleFilter::TParticleFilterOptions& PF_options,
+		const mrpt::bayes::CParticleFilterCapable* obj, size_t index,
+		const void* action, const void* observation,
+		mrpt::random::CRandomGenerator& rng)
 {
 	MRPT_UNUSED_PARAM(action);
 	MRPT_START
@@ -430,7 +563,7 @@ double PF_implementation<PARTICLE_TYPE, MYSELF>::
 	mrpt::poses::CPose3D drawnSample;
 	for (size_t q = 0; q < N; q++)
 	{
-		me->m_movementDrawer.drawSample(drawnSample);
+		me->m_movementDrawer.drawSample(drawnSample, rng);
 		mrpt::poses::CPose3D x_predict = oldPose + drawnSample;
 
 		// Estimate the mean...
@@ -483,6 +616,20 @@ double PF_implementation<PARTICLE_TYPE, MYSELF>::
 		const mrpt::bayes::CParticleFilter::TParticleFilterOptions& PF_options,
 		const mrpt::bayes::CParticleFilterCapable* obj, size_t index,
 		const void* action, const void* observation)
+{
+	return PF_SLAM_particlesEvaluator_AuxPFStandard_rng<BINTYPE>(
+		PF_options, obj, index, action, observation,
+		mrpt::random::getRandomGenerator());
+}
+
+template <class PARTICLE_TYPE, class MYSELF>
+template <class BINTYPE>
+double PF_implementation<PARTICLE_TYPE, MYSELF>::
+	PF_SLAM_particlesEvaluator_AuxPFStandard_rng(
+		const mrpt::bayes::CParticleFilter::TParticleFilterOptions& PF_options,
+		const mrpt::bayes::CParticleFilterCapable* obj, size_t index,
+		const void* action, const void* observation,
+		mrpt::random::CRandomGenerator& rng)
 {
 	MRPT_START
 
@@ -534,7 +681,7 @@ double PF_implementation<PARTICLE_TYPE, MYSELF>::
 		mrpt::poses::CPose3D drawnSample;
 		for (size_t q = 0; q < N; q++)
 		{
-			myObj->m_movementDrawer.drawSample(drawnSample);
+			myObj->m_movementDrawer.drawSample(drawnSample, rng);
 			mrpt::poses::CPose3D x_predict = oldPose + drawnSample;
 
 			// Estimate the mean...
@@ -624,14 +771,25 @@ void PF_implementation<PARTICLE_TYPE, MYSELF>::
 
 	// Prepare data for executing "fastDrawSample"
 	using TMyClass = PF_implementation<PARTICLE_TYPE, MYSELF>;
-	auto funcOpt =
-		&TMyClass::template PF_SLAM_particlesEvaluator_AuxPFOptimal<BINTYPE>;
-	auto funcStd =
-		&TMyClass::template PF_SLAM_particlesEvaluator_AuxPFStandard<BINTYPE>;
+	auto funcOpt = &TMyClass::template
+		PF_SLAM_particlesEvaluator_AuxPFOptimal_rng<BINTYPE>;
+	auto funcStd = &TMyClass::template
+		PF_SLAM_particlesEvaluator_AuxPFStandard_rng<BINTYPE>;
+	auto func = USE_OPTIMAL_SAMPLING ? funcOpt : funcStd;
+
+	// Evaluate the first stage weights (maybe in parallel), then let
+	// "prepareFastDrawSample" just take the precomputed values:
+	m_pfAuxiliaryPF_firstStageLogWeights.resize(M);
+	this->PF_SLAM_implementation_parallel_for(
+		PF_SLAM_implementation_numThreads(PF_options, sf), 0, M,
+		[&](size_t i, mrpt::random::CRandomGenerator& rng) {
+			m_pfAuxiliaryPF_firstStageLogWeights[i] =
+				func(PF_options, me, i, &meanRobotMovement, sf, rng);
+		});
 
 	me->prepareFastDrawSample(
-		PF_options, USE_OPTIMAL_SAMPLING ? funcOpt : funcStd,
-		&meanRobotMovement, sf);
+		PF_options, &TMyClass::PF_SLAM_particlesEvaluator_precomputed,
+		nullptr, &m_pfAuxiliaryPF_firstStageLogWeights);
 
 	// For USE_OPTIMAL_SAMPLING=1,  m_pfAuxiliaryPFOptimal_maxLikelihood is now
 	// computed.
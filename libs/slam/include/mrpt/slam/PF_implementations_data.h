@@ -18,6 +18,16 @@
 #include <mrpt/poses/CPoseRandomSampler.h>
 #include <mrpt/slam/TKLDParams.h>
 #include <mrpt/system/COutputLogger.h>
+#include <mrpt/system/CWorkerThreadsPool.h>
+#include <memory>
+
+namespace mrpt
+{
+namespace random
+{
+class CRandomGenerator;
+}
+}
 
 namespace mrpt
 {
@@ -67,6 +77,61 @@ class PF_implementation : public mrpt::system::COutputLogger
 	mutable std::vector<mrpt::math::TPose3D>
 		m_pfAuxiliaryPFOptimal_maxLikDrawnMovement;
 	std::vector<bool> m_pfAuxiliaryPFOptimal_maxLikMovementDrawHasBeenUsed;
+	/** Auxiliary variable used in the "pfAuxiliaryPF*" algorithms: the
+	 * first stage weights, evaluated (maybe in parallel) before resampling. */
+	std::vector<double> m_pfAuxiliaryPF_firstStageLogWeights;
+
+	/** Worker threads used when TParticleFilterOptions::numThreads!=1.
+	 * Created on demand, and re-created if the number of threads changes. */
+	mutable std::shared_ptr<mrpt::system::CWorkerThreadsPool> m_threadsPool;
+
+	/** In parallel mode, particles are processed in blocks of this size, each
+	 * block drawing its random numbers from an independent generator seeded
+	 * from the global one. Since blocks do not depend on the number of
+	 * threads, results are identical for a given random seed and any
+	 * number of threads other than 1. */
+	static constexpr size_t PARALLEL_BLOCK_SIZE = 64;
+
+	/** Invokes `func(i, rng)` for all particle indices `i` in the range
+	 * [first,last).
+	 * - If `numThreads==1`, this is a plain loop in the calling thread, with
+	 * `rng` being mrpt::random::getRandomGenerator().
+	 * - Otherwise (0 means one thread per core), the thread pool is used and
+	 * `rng` is a per-block random generator, with blocks of `blockSize`
+	 * indices (see PARALLEL_BLOCK_SIZE). The first index is evaluated in the
+	 * calling thread before launching the rest in parallel, so any
+	 * lazily-built cache in the observation data gets initialized without
+	 * races. `func` must be safe to call concurrently for different indices.
+	 */
+	template <class FUNCTOR>
+	void PF_SLAM_implementation_parallel_for(
+		const unsigned int numThreads, const size_t first, const size_t last,
+		FUNCTOR&& func, const size_t blockSize = PARALLEL_BLOCK_SIZE) const;
+
+	/** Returns the number of threads to be used for the next
+	 * PF_SLAM_implementation_parallel_for(): 1 if so set in
+	 * TParticleFilterOptions::numThreads, or if `sf` is not nullptr (i.e. the
+	 * observation likelihood is to be evaluated) and
+	 * PF_SLAM_implementation_prepareConcurrentLikelihood() refuses parallel
+	 * evaluation. TParticleFilterOptions::numThreads otherwise. */
+	unsigned int PF_SLAM_implementation_numThreads(
+		const mrpt::bayes::CParticleFilter::TParticleFilterOptions& PF_options,
+		const mrpt::obs::CSensoryFrame* sf) const;
+
+	/** A particle evaluator for mrpt::bayes::CParticleFilterCapable which
+	 * returns values already computed in parallel.
+	 * \param observation MUST be a "const std::vector<double>*"
+	 */
+	static double PF_SLAM_particlesEvaluator_precomputed(
+		const mrpt::bayes::CParticleFilter::TParticleFilterOptions& PF_options,
+		const mrpt::bayes::CParticleFilterCapable* obj, size_t index,
+		const void* action, const void* observation)
+	{
+		MRPT_UNUSED_PARAM(PF_options);
+		MRPT_UNUSED_PARAM(obj);
+		MRPT_UNUSED_PARAM(action);
+		return (*static_cast<const std::vector<double>*>(observation))[index];
+	}
 
 	/**  Compute w[i]*p(z_t | mu_t^i), with mu_t^i being
 	  *    the mean of the new robot pose
@@ -88,6 +153,24 @@ class PF_implementation : public mrpt::system::COutputLogger
 		const mrpt::bayes::CParticleFilterCapable* obj, size_t index,
 		const void* action, const void* observation);
 
+	/** Like PF_SLAM_particlesEvaluator_AuxPFStandard() and
+	 * PF_SLAM_particlesEvaluator_AuxPFOptimal(), but drawing the Monte-Carlo
+	 * samples from the given random generator. */
+	template <class BINTYPE>
+	static double PF_SLAM_particlesEvaluator_AuxPFStandard_rng(
+		const mrpt::bayes::CParticleFilter::TParticleFilterOptions& PF_options,
+		const mrpt::bayes::CParticleFilterCapable* obj, size_t index,
+		const void* action, const void* observation,
+		mrpt::random::CRandomGenerator& rng);
+
+	/** \overload */
+	template <class BINTYPE>
+	static double PF_SLAM_particlesEvaluator_AuxPFOptimal_rng(
+		const mrpt::bayes::CParticleFilter::TParticleFilterOptions& PF_options,
+		const mrpt::bayes::CParticleFilterCapable* obj, size_t index,
+		const void* action, const void* observation,
+		mrpt::random::CRandomGenerator& rng);
+
 	/** @} */
 
 	/** \name The generic PF implementations for localization & SLAM.
@@ -279,6 +362,46 @@ class PF_implementation : public mrpt::system::COutputLogger
 		const mrpt::obs::CSensoryFrame& observation,
 		const mrpt::poses::CPose3D& x) const = 0;
 
+	/** Called before evaluating PF_SLAM_computeObservationLikelihoodForParticle
+	 * from several threads at once (see
+	 * TParticleFilterOptions::numThreads). Implementations must leave the
+	 * observation model ready for concurrent evaluation (e.g. filling in
+	 * lazily-built caches) and return true, or return false if this is not
+	 * possible, in which case the likelihoods are evaluated sequentially.
+	 * By default, returns false. */
+	virtual bool PF_SLAM_implementation_prepareConcurrentLikelihood(
+		const mrpt::obs::CSensoryFrame& observation) const
+	{
+		MRPT_UNUSED_PARAM(observation);
+		return false;
+	}
+
+	/** Optional batch version of
+	 * PF_SLAM_computeObservationLikelihoodForParticle(), which evaluates the
+	 * observation likelihood for the consecutive particles starting at
+	 * `firstParticleIndex`, with poses `x`. It is called from
+	 * PF_SLAM_implementation_pfStandardProposal() with blocks of
+	 * PARALLEL_BLOCK_SIZE particles, maybe from several threads at once (see
+	 * PF_SLAM_implementation_prepareConcurrentLikelihood()).
+	 * Implementations must fill in `out_logLiks` with one log-likelihood per
+	 * pose and return true, or return false if not supported for this
+	 * observation, in which case they must do so for all the particles.
+	 * By default, returns false. */
+	virtual bool PF_SLAM_computeObservationLikelihoodForParticles(
+		const mrpt::bayes::CParticleFilter::TParticleFilterOptions& PF_options,
+		const size_t firstParticleIndex,
+		const mrpt::obs::CSensoryFrame& observation,
+		const std::vector<mrpt::math::TPose3D>& x,
+		std::vector<double>& out_logLiks) const
+	{
+		MRPT_UNUSED_PARAM(PF_options);
+		MRPT_UNUSED_PARAM(firstParticleIndex);
+		MRPT_UNUSED_PARAM(observation);
+		MRPT_UNUSED_PARAM(x);
+		MRPT_UNUSED_PARAM(out_logLiks);
+		return false;
+	}
+
 	/** @} */
 
 	/** Auxiliary method called by PF implementations: return true if we have
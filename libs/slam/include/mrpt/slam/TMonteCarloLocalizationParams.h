@@ -48,6 +48,16 @@ struct TMonteCarloLocalizationParams
 
 	/** Parameters for dynamic sample size, KLD method. */
 	TKLDParams KLD_params;
+
+	/** Fills in the internal caches of metricMap (or metricMaps) so that the
+	 * likelihood of observations can be evaluated from several threads at
+	 * once. Supported shared maps are: all point maps, occupancy grids with
+	 * the lmLikelihoodField_Thrun, lmLikelihoodField_II or lmConsensus
+	 * methods, and mrpt::maps::CMultiMetricMap made only of those. Any map
+	 * type is supported if each particle has its own map in metricMaps.
+	 * \return false if any map is not supported.
+	 * \note [New in MRPT 2.0.0] */
+	bool prepareMapsForConcurrentLikelihood() const;
 };
 
 }  // End of namespace
@@ -106,7 +106,8 @@ CICP::TConfigParams::TConfigParams()
 	  skip_cov_calculation(false),
 	  skip_quality_calculation(true),
 
-	  corresponding_points_decimation(5)
+	  corresponding_points_decimation(5),
+	  numThreads(1)
 {
 }
 
@@ -160,6 +161,7 @@ void CICP::TConfigParams::loadFromConfigFile(
 
 	MRPT_LOAD_CONFIG_VAR(
 		corresponding_points_decimation, int, iniFile, section);
+	MRPT_LOAD_CONFIG_VAR(numThreads, int, iniFile, section);
 }
 
 /*---------------------------------------------------------------
@@ -243,6 +245,9 @@ void CICP::TConfigParams::dumpToTextStream(std::ostream& out) const
 	out << mrpt::format(
 		"corresponding_points_decimation         = %u\n",
 		(unsigned int)corresponding_points_decimation);
+	out << mrpt::format(
+		"numThreads                              = %u\n",
+		(unsigned int)numThreads);
 	out << mrpt::format("\n");
 }
 
@@ -308,6 +313,7 @@ CPosePDF::Ptr CICP::ICP_Method_Classic(
 	matchParams.onlyUniqueRobust = options.onlyUniqueRobust;
 	matchParams.decimation_other_map_points =
 		options.corresponding_points_decimation;
+	matchParams.numThreads = options.numThreads;
 
 	// Asure maps are not empty!
 	// ------------------------------------------------------
@@ -679,6 +685,7 @@ CPosePDF::Ptr CICP::ICP_Method_LM(
 	matchParams.onlyUniqueRobust = onlyUniqueRobust;
 	matchParams.decimation_other_map_points =
 		options.corresponding_points_decimation;
+	matchParams.numThreads = options.numThreads;
 
 	// The gaussian PDF to estimate:
 	// ------------------------------------------------------
@@ -1088,6 +1095,7 @@ CPose3DPDF::Ptr CICP::ICP3D_Method_Classic(
 	matchParams.onlyUniqueRobust = options.onlyUniqueRobust;
 	matchParams.decimation_other_map_points =
 		options.corresponding_points_decimation;
+	matchParams.numThreads = options.numThreads;
 
 	// Asure maps are not empty!
 	// ------------------------------------------------------
@@ -194,6 +194,52 @@ double
 	return ret;
 }
 
+bool CMonteCarloLocalization2D::
+	PF_SLAM_implementation_prepareConcurrentLikelihood(
+		const CSensoryFrame& observation) const
+{
+	MRPT_UNUSED_PARAM(observation);
+	return options.prepareMapsForConcurrentLikelihood();
+}
+
+bool CMonteCarloLocalization2D::
+	PF_SLAM_computeObservationLikelihoodForParticles(
+		const CParticleFilter::TParticleFilterOptions& PF_options,
+		const size_t firstParticleIndex, const CSensoryFrame& observation,
+		const std::vector<TPose3D>& x, std::vector<double>& out_logLiks) const
+{
+	MRPT_UNUSED_PARAM(PF_options);
+	MRPT_UNUSED_PARAM(firstParticleIndex);
+	// Only for one grid map shared by all particles:
+	if (!options.metricMap || !IS_CLASS(options.metricMap, COccupancyGridMap2D))
+		return false;
+	auto grid = static_cast<COccupancyGridMap2D*>(options.metricMap);
+
+	std::vector<TPose2D> poses2D(x.size());
+	for (size_t i = 0; i < x.size(); i++) poses2D[i] = TPose2D(x[i]);
+
+	// For each observation, as in
+	// PF_SLAM_computeObservationLikelihoodForParticle():
+	out_logLiks.assign(x.size(), 1.0);
+	std::vector<double> obsLogLiks;
+	for (const auto& obs : observation)
+	{
+		if (grid->computeObservationLikelihoodBatch(
+				obs.get(), poses2D, obsLogLiks))
+		{
+			for (size_t i = 0; i < x.size(); i++)
+				out_logLiks[i] += obsLogLiks[i];
+		}
+		else
+		{
+			for (size_t i = 0; i < x.size(); i++)
+				out_logLiks[i] += grid->computeObservationLikelihood(
+					obs.get(), CPose3D(x[i]));
+		}
+	}
+	return true;
+}
+
 // Specialization for my kind of particles:
 void CMonteCarloLocalization2D::
 	PF_SLAM_implementation_custom_update_particle_with_new_pose(
@@ -12,6 +12,9 @@
 #include <mrpt/slam/CMonteCarloLocalization2D.h>
 #include <mrpt/maps/CMultiMetricMap.h>
 #include <mrpt/maps/CSimpleMap.h>
+#include <mrpt/maps/COccupancyGridMap2D.h>
+#include <mrpt/obs/CActionRobotMovement2D.h>
+#include <mrpt/obs/CObservation2DRangeScan.h>
 #include <mrpt/obs/CRawlog.h>
 #include <mrpt/system/filesystem.h>
 #include <mrpt/system/os.h>
@@ -313,3 +316,119 @@ TEST(MonteCarlo2D, RunSampleDataset)
 
 	FAIL() << "Failed to converge after 3 opportunities!!" << endl;
 }
+
+// Runs a few PF steps on a synthetic map, with the robot moving from a known
+// pose, and returns all particle poses and weights, so the outcome of
+// different thread counts can be compared.
+struct TPFParallelTestResult
+{
+	std::vector<double> particles;
+	CPose2D mean, groundTruth;
+};
+
+static TPFParallelTestResult run_test_pf_parallel(
+	const unsigned int numThreads,
+	const CParticleFilter::TParticleFilterAlgorithm algorithm,
+	const CActionRobotMovement2D::TDrawSampleMotionModel motionModel)
+{
+	getRandomGenerator().randomize(1234);
+
+	// A 6x6m room, with a box in one corner to break its symmetry:
+	COccupancyGridMap2D grid(-3, 3, -3, 3, 0.05f);
+	for (unsigned int cy = 0; cy < grid.getSizeY(); cy++)
+		for (unsigned int cx = 0; cx < grid.getSizeX(); cx++)
+		{
+			const bool wall = cx < 2 || cy < 2 || cx + 2 >= grid.getSizeX() ||
+							  cy + 2 >= grid.getSizeY();
+			const float x = grid.idx2x(cx), y = grid.idx2y(cy);
+			const bool box = x > 1.5f && x < 2.2f && y > -2.2f && y < -1.0f;
+			grid.setCell(cx, cy, (wall || box) ? 0.0f : 1.0f);
+		}
+	grid.likelihoodOptions.likelihoodMethod =
+		COccupancyGridMap2D::lmLikelihoodField_Thrun;
+
+	const CPose2D odoIncr(0.1, 0, 0.01);
+	CActionRobotMovement2D::TMotionModelOptions motionOpts;
+	motionOpts.modelSelection = motionModel;
+	CActionRobotMovement2D odo;
+	odo.computeFromOdometry(odoIncr, motionOpts);
+	CActionCollection acts;
+	acts.insert(odo);
+
+	CMonteCarloLocalization2D pdf;
+	pdf.options.metricMap = &grid;
+	pdf.resetUniform(0, 1, -0.2, 0.8, -0.3, 0.7, 500);
+
+	CParticleFilter PF;
+	PF.m_options.PF_algorithm = algorithm;
+	PF.m_options.pfAuxFilterOptimal_MaximumSearchSamples = 10;
+	PF.m_options.numThreads = numThreads;
+
+	TPFParallelTestResult res;
+	res.groundTruth = CPose2D(0.5, 0.3, 0.2);
+	for (int step = 0; step < 6; step++)
+	{
+		res.groundTruth = res.groundTruth + odoIncr;
+		auto scan = mrpt::make_aligned_shared<CObservation2DRangeScan>();
+		scan->aperture = M_PIf;
+		grid.laserScanSimulator(*scan, res.groundTruth, 0.5f, 181);
+		CSensoryFrame sf;
+		sf.insert(scan);
+
+		PF.executeOn(pdf, &acts, &sf);
+	}
+
+	for (const auto& p : pdf.m_particles)
+	{
+		res.particles.push_back(p.d->x());
+		res.particles.push_back(p.d->y());
+		res.particles.push_back(p.d->phi());
+		res.particles.push_back(p.log_w);
+	}
+	pdf.getMean(res.mean);
+	return res;
+}
+
+static const CParticleFilter::TParticleFilterAlgorithm pf_parallel_algs[] = {
+	CParticleFilter::pfStandardProposal, CParticleFilter::pfAuxiliaryPFStandard,
+	CParticleFilter::pfAuxiliaryPFOptimal};
+static const CActionRobotMovement2D::TDrawSampleMotionModel
+	pf_parallel_models[] = {CActionRobotMovement2D::mmGaussian,
+							CActionRobotMovement2D::mmThrun};
+
+TEST(MonteCarlo2D, ParallelIsDeterministic)
+{
+	for (const auto algorithm : pf_parallel_algs)
+		for (const auto model : pf_parallel_models)
+		{
+			const auto res2 = run_test_pf_parallel(2, algorithm, model);
+			const auto res3 = run_test_pf_parallel(3, algorithm, model);
+			EXPECT_FALSE(res2.particles.empty());
+			EXPECT_TRUE(res2.particles == res3.particles)
+				<< "Parallel PF results depend on the number of threads for "
+				   "algorithm #"
+				<< static_cast<int>(algorithm) << " motion model #"
+				<< static_cast<int>(model);
+		}
+}
+
+TEST(MonteCarlo2D, ParallelConverges)
+{
+	for (const auto algorithm : pf_parallel_algs)
+		for (const auto model : pf_parallel_models)
+			for (const unsigned int nThreads : {1u, 4u})
+			{
+				const auto res =
+					run_test_pf_parallel(nThreads, algorithm, model);
+				const CPose2D err = res.mean - res.groundTruth;
+				EXPECT_LT(err.norm(), 0.15)
+					<< "algorithm #" << static_cast<int>(algorithm)
+					<< " motion model #" << static_cast<int>(model)
+					<< " numThreads=" << nThreads << " mean=" << res.mean
+					<< " groundTruth=" << res.groundTruth;
+				EXPECT_LT(std::abs(err.phi()), DEG2RAD(6.0))
+					<< "algorithm #" << static_cast<int>(algorithm)
+					<< " motion model #" << static_cast<int>(model)
+					<< " numThreads=" << nThreads;
+			}
+}
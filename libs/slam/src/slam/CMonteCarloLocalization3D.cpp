@@ -196,6 +196,14 @@ double
 	return ret;
 }
 
+bool CMonteCarloLocalization3D::
+	PF_SLAM_implementation_prepareConcurrentLikelihood(
+		const CSensoryFrame& observation) const
+{
+	MRPT_UNUSED_PARAM(observation);
+	return options.prepareMapsForConcurrentLikelihood();
+}
+
 // Specialization for my kind of particles:
 void CMonteCarloLocalization3D::
 	PF_SLAM_implementation_custom_update_particle_with_new_pose(
@@ -1032,3 +1032,10 @@ double CMultiMetricMapPDF::PF_SLAM_computeObservationLikelihoodForParticle(
 		ret += map->computeObservationLikelihood((CObservation*)it->get(), x);
 	return ret;
 }
+
+bool CMultiMetricMapPDF::PF_SLAM_implementation_prepareConcurrentLikelihood(
+	const CSensoryFrame& observation) const
+{
+	MRPT_UNUSED_PARAM(observation);
+	return true;
+}
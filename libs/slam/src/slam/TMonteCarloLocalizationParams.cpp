@@ -10,8 +10,13 @@
 #include "slam-precomp.h"  // Precompiled headerss
 
 #include <mrpt/slam/TMonteCarloLocalizationParams.h>
+#include <mrpt/maps/CMultiMetricMap.h>
+#include <mrpt/maps/COccupancyGridMap2D.h>
+#include <mrpt/maps/CPointsMap.h>
+#include <set>
 
 using namespace mrpt;
+using namespace mrpt::maps;
 using namespace mrpt::slam;
 using namespace std;
 
@@ -39,3 +44,57 @@ TMonteCarloLocalizationParams& TMonteCarloLocalizationParams::operator=(
 	KLD_params = o.KLD_params;
 	return *this;
 }
+
+static bool prepareMapForConcurrentLikelihood(CMetricMap* m)
+{
+	if (!m) return false;
+	if (IS_CLASS(m, COccupancyGridMap2D))
+	{
+		auto grid = static_cast<COccupancyGridMap2D*>(m);
+		switch (grid->likelihoodOptions.likelihoodMethod)
+		{
+			case COccupancyGridMap2D::lmLikelihoodField_Thrun:
+				grid->precomputeLikelihoodFieldCache();
+				return true;
+			case COccupancyGridMap2D::lmLikelihoodField_II:
+			case COccupancyGridMap2D::lmConsensus:
+				return true;
+			default:
+				return false;
+		};
+	}
+	if (IS_DERIVED(m, CPointsMap))
+	{
+		// Build both KD-trees now, since queries are then reentrant:
+		auto pts = static_cast<CPointsMap*>(m);
+		if (pts->size() != 0)
+		{
+			float x, y, z, dist_sqr;
+			pts->kdTreeClosestPoint2D(0, 0, x, y, dist_sqr);
+			pts->kdTreeClosestPoint3D(0, 0, 0, x, y, z, dist_sqr);
+		}
+		return true;
+	}
+	if (IS_CLASS(m, CMultiMetricMap))
+	{
+		for (auto& sub_map : static_cast<CMultiMetricMap*>(m)->maps)
+			if (!prepareMapForConcurrentLikelihood(sub_map.get()))
+				return false;
+		return true;
+	}
+	return false;
+}
+
+bool TMonteCarloLocalizationParams::prepareMapsForConcurrentLikelihood() const
+{
+	if (metricMap) return prepareMapForConcurrentLikelihood(metricMap);
+
+	// One map per particle: each particle is evaluated by one thread only,
+	// so any map type is fine as long as no map is shared between particles:
+	const std::set<CMetricMap*> uniqueMaps(
+		metricMaps.begin(), metricMaps.end());
+	if (uniqueMaps.size() == metricMaps.size()) return true;
+	for (auto m : uniqueMaps)
+		if (!prepareMapForConcurrentLikelihood(m)) return false;
+	return true;
+}
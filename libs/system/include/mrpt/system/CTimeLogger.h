@@ -11,9 +11,9 @@
 #include <mrpt/system/CTicTac.h>
 #include <mrpt/system/COutputLogger.h>
 #include <mrpt/core/exceptions.h>
-#include <mrpt/containers/ts_hash_map.h>
+#include <cstdint>
+#include <memory>
 #include <vector>
-#include <stack>
 #include <map>
 
 namespace mrpt
@@ -25,15 +25,30 @@ namespace system
  *  The results can be dumped to cout or to Visual Studio's output panel.
  *  Recursive methods are supported with no problems, that is, calling "enter(X)
  * enter(X) ... leave(X) leave(X)".
- *  `enter()`/`leave()` are thread-safe.
+ *  `enter()`/`leave()` are thread-safe: each thread must call `leave(X)` for
+ * its own `enter(X)` calls, and the stats of all threads are merged in the
+ * reports.
  *
  *  This class can be also used to monitorize min/mean/max/total stats of any
  * user-provided parameters via the method CTimeLogger::registerUserMeasure()
  *
- * Cost of the profiler itself (measured on MSVC2015, Windows 10, Intel i5-2310
- * 2.9GHz):
- * - `enter()`: average 445 ns
- * - `leave()`: average 316 ns
+ * Implementation details:
+ * - Section names are interned into integer IDs (see getSectionID()). Each
+ *   thread keeps a small cache of the `const char*` names it uses, so
+ *   `enter("name")` with string literals does not hash nor allocate strings.
+ *   Critical code can also call `enter()`/`leave()` with a TSectionID.
+ * - Each thread accumulates its stats into its own buffers, without locks:
+ *   the mutex of the logger is only taken the first time a thread or a name
+ *   is seen, and by the methods that build reports.
+ * - Times are measured with a monotonic clock with nanosecond resolution.
+ * - If enabled with enableEventTrace(), each enter-leave pair is also stored
+ *   as an event, which can be exported with saveToChromeTraceFile() as a
+ *   timeline of all threads, viewable with Chrome's `chrome://tracing`.
+ *
+ * Cost of the profiler itself (measured on GCC 12, Linux, in a VM where
+ * reading the clock takes ~30 ns):
+ * - `enter()` + `leave()` with a string literal: ~100 ns
+ * - Same, with a TSectionID: ~80 ns
  *
  * \sa CTimeLoggerEntry
  *
@@ -42,31 +57,27 @@ namespace system
  */
 class CTimeLogger : public mrpt::system::COutputLogger
 {
+   public:
+	/** An interned section name, see getSectionID() */
+	enum class TSectionID : uint32_t
+	{
+	};
+
    private:
-	CTicTac m_tictac;
 	bool m_enabled;
 	std::string m_name;
 
-	//! Data of all the calls:
-	struct TCallData
-	{
-		TCallData();
-
-		size_t n_calls;
-		double min_t, max_t, mean_t, last_t;
-		std::stack<double, std::vector<double>> open_calls;
-		bool has_time_units;
-	};
+	struct Impl;
+	std::unique_ptr<Impl> m_impl;
 
    protected:
-	using TDataMap =
-		mrpt::containers::ts_hash_map<std::string, TCallData,
-									  1 /* bytes hash */,
-									  10 /* allowed hash collisions */>;
-	TDataMap m_data;
-
 	void do_enter(const char* func_name);
 	double do_leave(const char* func_name);
+	void do_enter(TSectionID id);
+	double do_leave(TSectionID id);
+	/** Returns true if any section has been ever entered (or registered with
+	 * getSectionID()) since construction or the last clear(true) */
+	bool hasSections() const;
 
    public:
 	/** Data of each call section: # of calls, minimum, maximum, average and
@@ -99,9 +110,10 @@ class CTimeLogger : public mrpt::system::COutputLogger
 	/** Dump all stats through the COutputLogger interface. \sa getStatsAsText,
 	 * saveToCVSFile */
 	void dumpAllStats(const size_t column_width = 80) const;
-	/** Resets all stats. By default (deep_clear=false), all section names are
-	 * remembered (not freed) so the cost of creating upon the first next call
-	 * is avoided. */
+	/** Resets all stats and trace events. By default (deep_clear=false), all
+	 * section names are remembered (not freed) so the cost of creating upon
+	 * the first next call is avoided.
+	 * \note Must not be called while other threads are within a section. */
 	void clear(bool deep_clear = false);
 	void enable(bool enabled = true) { m_enabled = enabled; }
 	void disable() { m_enabled = false; }
@@ -111,18 +123,40 @@ class CTimeLogger : public mrpt::system::COutputLogger
 	void saveToCSVFile(const std::string& csv_file) const;
 	void registerUserMeasure(const char* event_name, const double value);
 
+	/** Enables (or disables) recording each enter-leave pair as an event,
+	 * for saveToChromeTraceFile(). Disabled by default, since events are
+	 * kept in memory (24 bytes each) until clear(). */
+	void enableEventTrace(bool enabled = true);
+	bool isEventTraceEnabled() const;
+	/** Saves all recorded events (see enableEventTrace()) as a JSON file in
+	 * the Chrome "Trace Event Format", with one timeline per thread. Open it
+	 * from `chrome://tracing` or https://ui.perfetto.dev/
+	 * \exception std::exception On error writing the file. */
+	void saveToChromeTraceFile(const std::string& json_file) const;
+
 	void setName(const std::string& name) { m_name = name; }
+	/** Returns the interned ID of a section name, to be passed to
+	 * enter()/leave() to save looking up the name in time-critical code.
+	 * IDs remain valid until clear(true). */
+	TSectionID getSectionID(const char* func_name);
 	/** Start of a named section \sa enter */
 	inline void enter(const char* func_name)
 	{
 		if (m_enabled) do_enter(func_name);
 	}
+	/** \overload */
+	inline void enter(TSectionID id)
+	{
+		if (m_enabled) do_enter(id);
+	}
 	/** End of a named section \return The ellapsed time, in seconds or 0 if
 	 * disabled. \sa enter */
 	inline double leave(const char* func_name)
 	{
 		return m_enabled ? do_leave(func_name) : 0;
 	}
+	/** \overload */
+	inline double leave(TSectionID id) { return m_enabled ? do_leave(id) : 0; }
 	/** Return the mean execution time of the given "section", or 0 if it hasn't
 	 * ever been called "enter" with that section name */
 	double getMeanTime(const std::string& name) const;
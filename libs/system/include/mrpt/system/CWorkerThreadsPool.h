@@ -0,0 +1,101 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/core/exceptions.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace mrpt
+{
+namespace system
+{
+/** A simple pool of persistent worker threads which execute tasks from a FIFO
+ * queue. Threads are created once in the constructor and kept alive until the
+ * object is destroyed, so submitting work costs a queue push plus a condition
+ * variable notification, instead of the creation of a new `std::thread`.
+ *
+ * Usage:
+ * \code
+ * mrpt::system::CWorkerThreadsPool pool(4);
+ * auto fut = pool.enqueue([](int a) { return 2 * a; }, 21);
+ * int r = fut.get();  // r=42
+ * \endcode
+ *
+ * Exceptions thrown from within a task are caught and re-thrown by
+ * `std::future::get()` in the calling thread.
+ *
+ * \note [New in MRPT 2.0.0]
+ * \ingroup mrpt_system_grp
+ */
+class CWorkerThreadsPool
+{
+   public:
+	/** Creates the pool with the given number of threads. If `num_threads`
+	 * is 0, the number of hardware threads is used instead. */
+	explicit CWorkerThreadsPool(std::size_t num_threads = 0);
+	/** Waits for all running tasks to end, discards pending ones and joins
+	 * all threads. */
+	~CWorkerThreadsPool();
+
+	CWorkerThreadsPool(const CWorkerThreadsPool&) = delete;
+	CWorkerThreadsPool& operator=(const CWorkerThreadsPool&) = delete;
+
+	/** Enqueues a new task. \return A future for the value returned by the
+	 * task. \exception std::exception If the pool was already stopped with
+	 * clear(). */
+	template <class F, class... Args>
+	auto enqueue(F&& f, Args&&... args)
+		-> std::future<typename std::result_of<F(Args...)>::type>
+	{
+		using return_type = typename std::result_of<F(Args...)>::type;
+
+		auto task = std::make_shared<std::packaged_task<return_type()>>(
+			std::bind(std::forward<F>(f), std::forward<Args>(args)...));
+
+		std::future<return_type> res = task->get_future();
+		{
+			std::unique_lock<std::mutex> lock(m_queue_mutex);
+			if (m_do_stop)
+				THROW_EXCEPTION("Cannot enqueue tasks in a stopped pool");
+			m_tasks.emplace([task]() { (*task)(); });
+		}
+		m_condition.notify_one();
+		return res;
+	}
+
+	/** Number of worker threads in the pool */
+	std::size_t size() const;
+
+	/** Number of tasks waiting in the queue to be picked by a worker */
+	std::size_t pendingTasks() const noexcept;
+
+	/** Stops all threads. Pending tasks in the queue are discarded (their
+	 * futures will report a `std::future_error`). Called from the
+	 * destructor. Calling enqueue() afterwards throws an exception. */
+	void clear();
+
+   private:
+	std::vector<std::thread> m_threads;
+	std::atomic_bool m_do_stop{false};
+	mutable std::mutex m_queue_mutex;
+	std::condition_variable m_condition;
+	std::queue<std::function<void()>> m_tasks;
+};
+
+}  // namespace system
+}  // namespace mrpt
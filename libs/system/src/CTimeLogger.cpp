@@ -12,19 +12,410 @@
 #include <mrpt/system/CTimeLogger.h>
 #include <mrpt/system/string_utils.h>
 #include <mrpt/core/bits_math.h>
-#include <iostream>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <deque>
 #include <fstream>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 
 using namespace mrpt;
 using namespace mrpt::system;
 using namespace std;
 
+// ------------------------------------------------------------------------
+//  Per-thread buffers
+// ------------------------------------------------------------------------
+namespace
+{
+using steady_clock = std::chrono::steady_clock;
+inline int64_t now_ns()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			   steady_clock::now().time_since_epoch())
+		.count();
+}
+
+// Stats of one section in one thread. Only written by the owner thread, but
+// read by any thread building a report, hence the (relaxed) atomics.
+struct TSectionStats
+{
+	std::atomic<uint64_t> n_calls{0};
+	std::atomic<double> min_t{0}, max_t{0}, total_t{0}, last_t{0};
+	std::atomic<int64_t> last_stamp{0};
+	std::atomic<bool> has_time_units{true};
+
+	void reset()
+	{
+		n_calls.store(0, std::memory_order_relaxed);
+		min_t.store(0, std::memory_order_relaxed);
+		max_t.store(0, std::memory_order_relaxed);
+		total_t.store(0, std::memory_order_relaxed);
+		last_t.store(0, std::memory_order_relaxed);
+		last_stamp.store(0, std::memory_order_relaxed);
+		has_time_units.store(true, std::memory_order_relaxed);
+	}
+	void add(double v, int64_t stamp)
+	{
+		const auto n = n_calls.load(std::memory_order_relaxed);
+		const auto r = std::memory_order_relaxed;
+		if (n == 0)
+		{
+			min_t.store(v, r);
+			max_t.store(v, r);
+		}
+		else
+		{
+			if (v < min_t.load(r)) min_t.store(v, r);
+			if (v > max_t.load(r)) max_t.store(v, r);
+		}
+		total_t.store(total_t.load(r) + v, r);
+		last_t.store(v, r);
+		last_stamp.store(stamp, r);
+		n_calls.store(n + 1, std::memory_order_release);
+	}
+};
+
+// Sections are stored in chunks so readers never see a reallocation:
+constexpr size_t SECTIONS_PER_CHUNK = 256;
+constexpr size_t MAX_CHUNKS = 1024;
+constexpr size_t MAX_SECTIONS = SECTIONS_PER_CHUNK * MAX_CHUNKS;
+
+// A completed enter-leave pair, for the event trace:
+struct TEvent
+{
+	uint32_t id;
+	int64_t t0, t1;
+};
+// A block of events, appended by the owner thread and published with the
+// release store of `count`:
+struct TEventBlock
+{
+	static constexpr size_t CAPACITY = 4096;
+	TEvent events[CAPACITY];
+	std::atomic<size_t> count{0};
+	std::atomic<TEventBlock*> next{nullptr};
+};
+
+struct TThreadData
+{
+	TThreadData(std::thread::id owner_, uint32_t tid_)
+		: owner(owner_), tid(tid_)
+	{
+		for (auto& c : chunks) c.store(nullptr, std::memory_order_relaxed);
+	}
+	~TThreadData()
+	{
+		for (auto& c : chunks) delete[] c.load(std::memory_order_relaxed);
+		clearEvents();
+	}
+	TThreadData(const TThreadData&) = delete;
+	TThreadData& operator=(const TThreadData&) = delete;
+
+	const std::thread::id owner;
+	/** Sequential thread number, for traces */
+	const uint32_t tid;
+
+	std::array<std::atomic<TSectionStats*>, MAX_CHUNKS> chunks;
+
+	/** For the owner thread: stats of a section, created if needed */
+	TSectionStats& stats(uint32_t id)
+	{
+		auto& chunk = chunks[id / SECTIONS_PER_CHUNK];
+		TSectionStats* c = chunk.load(std::memory_order_relaxed);
+		if (!c)
+		{
+			c = new TSectionStats[SECTIONS_PER_CHUNK];
+			chunk.store(c, std::memory_order_release);
+		}
+		return c[id % SECTIONS_PER_CHUNK];
+	}
+	/** For readers: nullptr if the section was never used by this thread */
+	const TSectionStats* findStats(uint32_t id) const
+	{
+		const TSectionStats* c =
+			chunks[id / SECTIONS_PER_CHUNK].load(std::memory_order_acquire);
+		return c ? &c[id % SECTIONS_PER_CHUNK] : nullptr;
+	}
+	void resetStats()
+	{
+		for (auto& chunk : chunks)
+		{
+			TSectionStats* c = chunk.load(std::memory_order_acquire);
+			if (c)
+				for (size_t i = 0; i < SECTIONS_PER_CHUNK; i++) c[i].reset();
+		}
+		open_calls.clear();
+	}
+
+	/** Start times of the open calls of each section (owner thread only) */
+	std::vector<std::vector<int64_t>> open_calls;
+
+	std::atomic<TEventBlock*> first_block{nullptr};
+	TEventBlock* last_block{nullptr};
+
+	void addEvent(uint32_t id, int64_t t0, int64_t t1)
+	{
+		TEventBlock* b = last_block;
+		if (!b || b->count.load(std::memory_order_relaxed) ==
+					  TEventBlock::CAPACITY)
+		{
+			auto* nb = new TEventBlock;
+			if (b)
+				b->next.store(nb, std::memory_order_release);
+			else
+				first_block.store(nb, std::memory_order_release);
+			last_block = b = nb;
+		}
+		const size_t n = b->count.load(std::memory_order_relaxed);
+		b->events[n] = TEvent{id, t0, t1};
+		b->count.store(n + 1, std::memory_order_release);
+	}
+	template <class FUNCTOR>
+	void forEachEvent(FUNCTOR f) const
+	{
+		for (const TEventBlock* b =
+				 first_block.load(std::memory_order_acquire);
+			 b; b = b->next.load(std::memory_order_acquire))
+		{
+			const size_t n = b->count.load(std::memory_order_acquire);
+			for (size_t i = 0; i < n; i++) f(b->events[i]);
+		}
+	}
+	void clearEvents()
+	{
+		TEventBlock* b = first_block.load(std::memory_order_acquire);
+		while (b)
+		{
+			TEventBlock* next = b->next.load(std::memory_order_acquire);
+			delete b;
+			b = next;
+		}
+		first_block.store(nullptr, std::memory_order_release);
+		last_block = nullptr;
+	}
+
+	/** Cache of `const char*` => section ID. The interned name is compared
+	 * too, since the same address may hold different (non-literal) names
+	 * along time. */
+	struct TNameCacheEntry
+	{
+		const char* key{nullptr};
+		const char* name{nullptr};
+		uint32_t id{0};
+		uint32_t generation{0};
+	};
+	std::array<TNameCacheEntry, 64> name_cache;
+};
+
+// Per-thread cache of logger => its thread data. Loggers are identified by
+// a unique, never reused, number so stale entries are harmless.
+struct TThreadLoggerEntry
+{
+	uint64_t logger_uid{0};
+	TThreadData* data{nullptr};
+};
+constexpr size_t THREAD_CACHE_SIZE = 8;
+thread_local std::array<TThreadLoggerEntry, THREAD_CACHE_SIZE>
+	tls_logger_cache;
+thread_local unsigned int tls_logger_cache_next = 0;
+
+std::atomic<uint64_t> logger_uid_counter{0};
+}  // namespace
+
+struct CTimeLogger::Impl
+{
+	Impl() = default;
+	Impl(const Impl& o);
+	Impl& operator=(const Impl&) = delete;
+
+	const uint64_t uid{++logger_uid_counter};
+	const int64_t t0{now_ns()};
+	std::atomic<bool> trace_enabled{false};
+
+	// All below, protected by this mutex:
+	mutable std::mutex mtx;
+	/** Interned names, with stable addresses */
+	std::deque<std::string> names;
+	std::unordered_map<std::string, uint32_t> name2id;
+	/** Incremented upon clear(true) to invalidate the name caches */
+	std::atomic<uint32_t> generation{0};
+	std::vector<std::unique_ptr<TThreadData>> threads;
+
+	/** The data of the calling thread, created if needed */
+	TThreadData* threadData()
+	{
+		for (const auto& e : tls_logger_cache)
+			if (e.logger_uid == uid) return e.data;
+
+		TThreadData* td = nullptr;
+		{
+			std::lock_guard<std::mutex> lck(mtx);
+			const auto me = std::this_thread::get_id();
+			for (const auto& t : threads)
+				if (t->owner == me) td = t.get();
+			if (!td)
+			{
+				threads.emplace_back(new TThreadData(
+					me, static_cast<uint32_t>(threads.size())));
+				td = threads.back().get();
+			}
+		}
+		tls_logger_cache[tls_logger_cache_next++ % THREAD_CACHE_SIZE] =
+			TThreadLoggerEntry{uid, td};
+		return td;
+	}
+
+	uint32_t intern(const char* name)
+	{
+		std::lock_guard<std::mutex> lck(mtx);
+		return internNoLock(name);
+	}
+	uint32_t internNoLock(const std::string& name)
+	{
+		const auto it = name2id.find(name);
+		if (it != name2id.end()) return it->second;
+		ASSERTMSG_(names.size() < MAX_SECTIONS, "Too many sections");
+		const auto id = static_cast<uint32_t>(names.size());
+		names.push_back(name);
+		name2id[name] = id;
+		return id;
+	}
+
+	uint32_t sectionID(TThreadData& td, const char* name)
+	{
+		auto& e = td.name_cache
+					  [(reinterpret_cast<std::uintptr_t>(name) >> 3) %
+					   td.name_cache.size()];
+		const auto gen = generation.load(std::memory_order_relaxed);
+		if (e.key == name && e.generation == gen && !strcmp(e.name, name))
+			return e.id;
+		uint32_t id;
+		const char* interned;
+		{
+			std::lock_guard<std::mutex> lck(mtx);
+			id = internNoLock(name);
+			interned = names[id].c_str();
+		}
+		e = TThreadData::TNameCacheEntry{name, interned, id, gen};
+		return id;
+	}
+
+	void enter(uint32_t id)
+	{
+		TThreadData& td = *threadData();
+		if (td.open_calls.size() <= id) td.open_calls.resize(id + 1);
+		td.open_calls[id].push_back(now_ns());
+	}
+	double leave(uint32_t id)
+	{
+		const int64_t t1 = now_ns();
+		TThreadData& td = *threadData();
+		if (id >= td.open_calls.size() || td.open_calls[id].empty())
+			return 0;  // This shouldn't happen!
+		auto& open = td.open_calls[id];
+		const int64_t tstart = open.back();
+		open.pop_back();
+
+		const double At = (t1 - tstart) * 1e-9;
+		td.stats(id).add(At, t1);
+		if (trace_enabled.load(std::memory_order_relaxed))
+			td.addEvent(id, tstart, t1);
+		return At;
+	}
+
+	struct TMergedStats
+	{
+		CTimeLogger::TCallStats stats;
+		bool has_time_units;
+	};
+	/** Merge the stats of all threads, must be called with mtx locked */
+	TMergedStats mergedStats(uint32_t id) const
+	{
+		TMergedStats r;
+		auto& s = r.stats;
+		s.n_calls = 0;
+		s.min_t = s.max_t = s.mean_t = s.total_t = s.last_t = 0;
+		r.has_time_units = true;
+		int64_t last_stamp = 0;
+		const auto rlx = std::memory_order_relaxed;
+		for (const auto& t : threads)
+		{
+			const TSectionStats* ts = t->findStats(id);
+			if (!ts) continue;
+			const auto n = ts->n_calls.load(std::memory_order_acquire);
+			if (!n) continue;
+			const double mi = ts->min_t.load(rlx), ma = ts->max_t.load(rlx);
+			if (s.n_calls == 0 || mi < s.min_t) s.min_t = mi;
+			if (s.n_calls == 0 || ma > s.max_t) s.max_t = ma;
+			s.n_calls += n;
+			s.total_t += ts->total_t.load(rlx);
+			if (ts->last_stamp.load(rlx) >= last_stamp)
+			{
+				last_stamp = ts->last_stamp.load(rlx);
+				s.last_t = ts->last_t.load(rlx);
+			}
+			if (!ts->has_time_units.load(rlx)) r.has_time_units = false;
+		}
+		s.mean_t = s.n_calls ? s.total_t / s.n_calls : 0;
+		return r;
+	}
+	/** All sections, sorted by name. */
+	std::map<std::string, TMergedStats> allMergedStats() const
+	{
+		std::lock_guard<std::mutex> lck(mtx);
+		std::map<std::string, TMergedStats> ret;
+		for (uint32_t id = 0; id < names.size(); id++)
+			ret[names[id]] = mergedStats(id);
+		return ret;
+	}
+};
+
+CTimeLogger::Impl::Impl(const Impl& o)
+{
+	std::lock_guard<std::mutex> lck(o.mtx);
+	trace_enabled = o.trace_enabled.load();
+	names = o.names;
+	name2id = o.name2id;
+	// Copy the stats and events of each thread, with the same owners (but
+	// not the open calls):
+	for (const auto& ot : o.threads)
+	{
+		threads.emplace_back(new TThreadData(ot->owner, ot->tid));
+		TThreadData& t = *threads.back();
+		for (uint32_t id = 0; id < names.size(); id++)
+		{
+			const TSectionStats* os = ot->findStats(id);
+			if (!os) continue;
+			TSectionStats& s = t.stats(id);
+			s.n_calls = os->n_calls.load();
+			s.min_t = os->min_t.load();
+			s.max_t = os->max_t.load();
+			s.total_t = os->total_t.load();
+			s.last_t = os->last_t.load();
+			s.last_stamp = os->last_stamp.load();
+			s.has_time_units = os->has_time_units.load();
+		}
+		ot->forEachEvent([&t, &o, this](const TEvent& ev) {
+			// Keep the same time reference:
+			t.addEvent(ev.id, ev.t0 - o.t0 + t0, ev.t1 - o.t0 + t0);
+		});
+	}
+}
+
+// ------------------------------------------------------------------------
+//  Global profiler
+// ------------------------------------------------------------------------
 struct MyGlobalProfiler : public mrpt::system::CTimeLogger
 {
 	MyGlobalProfiler() : mrpt::system::CTimeLogger("MRPT_global_profiler") {}
 	~MyGlobalProfiler()
 	{
-		if (!m_data.empty())
+		if (hasSections())
 		{
 			const std::string sFil("mrpt-global-profiler.csv");
 			this->saveToCSVFile(sFil);
@@ -53,15 +444,15 @@ void global_profiler_leave(const char* func_name) noexcept
 
 CTimeLogger::CTimeLogger(
 	bool enabled /*=true*/, const std::string& name /*=""*/)
-	: COutputLogger("CTimeLogger"), m_tictac(), m_enabled(enabled), m_name(name)
+	: COutputLogger("CTimeLogger"), m_enabled(enabled), m_name(name)
 {
-	m_tictac.Tic();
+	m_impl.reset(new Impl());
 }
 
 CTimeLogger::~CTimeLogger()
 {
 	// Dump all stats:
-	if (!m_data.empty())  // If logging is disabled, do nothing...
+	if (hasSections())  // If logging is disabled, do nothing...
 		dumpAllStats();
 }
 
@@ -69,7 +460,7 @@ CTimeLogger::CTimeLogger(const CTimeLogger& o)
 	: COutputLogger(o),
 	  m_enabled(o.m_enabled),
 	  m_name(o.m_name),
-	  m_data(o.m_data)
+	  m_impl(new Impl(*o.m_impl))
 {
 }
 CTimeLogger& CTimeLogger::operator=(const CTimeLogger& o)
@@ -77,35 +468,66 @@ CTimeLogger& CTimeLogger::operator=(const CTimeLogger& o)
 	COutputLogger::operator=(o);
 	m_enabled = o.m_enabled;
 	m_name = o.m_name;
-	m_data = o.m_data;
+	if (this != &o) m_impl.reset(new Impl(*o.m_impl));
 	return *this;
 }
 CTimeLogger::CTimeLogger(CTimeLogger&& o)
 	: COutputLogger(o),
 	  m_enabled(o.m_enabled),
 	  m_name(o.m_name),
-	  m_data(o.m_data)
+	  m_impl(std::move(o.m_impl))
 {
+	// Leave the moved-from object in a valid (empty) state:
+	o.m_impl.reset(new Impl());
 }
 CTimeLogger& CTimeLogger::operator=(CTimeLogger&& o)
 {
 	COutputLogger::operator=(o);
 	m_enabled = o.m_enabled;
 	m_name = o.m_name;
-	m_data = o.m_data;
+	if (this == &o) return *this;
+	m_impl.swap(o.m_impl);
+	o.m_impl.reset(new Impl());
 	return *this;
 }
 
+bool CTimeLogger::hasSections() const
+{
+	std::lock_guard<std::mutex> lck(m_impl->mtx);
+	return !m_impl->names.empty();
+}
+
 void CTimeLogger::clear(bool deep_clear)
 {
+	Impl& d = *m_impl;
+	std::lock_guard<std::mutex> lck(d.mtx);
+	for (auto& t : d.threads)
+	{
+		t->resetStats();
+		t->clearEvents();
+	}
 	if (deep_clear)
-		m_data.clear();
-	else
 	{
-		for (auto& e : m_data) e.second = TCallData();
+		d.names.clear();
+		d.name2id.clear();
+		d.generation++;
 	}
 }
 
+void CTimeLogger::enableEventTrace(bool enabled)
+{
+	m_impl->trace_enabled = enabled;
+}
+bool CTimeLogger::isEventTraceEnabled() const
+{
+	return m_impl->trace_enabled;
+}
+
+CTimeLogger::TSectionID CTimeLogger::getSectionID(const char* func_name)
+{
+	return static_cast<TSectionID>(m_impl->intern(func_name));
+}
+
 std::string aux_format_string_multilines(const std::string& s, const size_t len)
 {
 	std::string ret;
@@ -121,16 +543,8 @@ std::string aux_format_string_multilines(const std::string& s, const size_t len)
 void CTimeLogger::getStats(std::map<std::string, TCallStats>& out_stats) const
 {
 	out_stats.clear();
-	for (const auto e : m_data)
-	{
-		TCallStats& cs = out_stats[e.first];
-		cs.min_t = e.second.min_t;
-		cs.max_t = e.second.max_t;
-		cs.total_t = e.second.mean_t;
-		cs.mean_t = e.second.n_calls ? e.second.mean_t / e.second.n_calls : 0;
-		cs.n_calls = e.second.n_calls;
-		cs.last_t = e.second.last_t;
-	}
+	for (const auto& e : m_impl->allMergedStats())
+		out_stats[e.first] = e.second.stats;
 }
 
 std::string CTimeLogger::getStatsAsText(const size_t column_width) const
@@ -163,23 +577,20 @@ std::string CTimeLogger::getStatsAsText(const size_t column_width) const
 	stats_text += bottom_header + "\n";
 
 	// for all the timed sections
-	for (const auto i : m_data)
+	for (const auto& i : m_impl->allMergedStats())
 	{
-		const string sMinT = unitsFormat(i.second.min_t, 1, false);
-		const string sMaxT = unitsFormat(i.second.max_t, 1, false);
-		const string sTotalT = unitsFormat(i.second.mean_t, 1, false);
-		const string sMeanT = unitsFormat(
-			i.second.n_calls ? i.second.mean_t / i.second.n_calls : 0, 1,
-			false);
+		const TCallStats& st = i.second.stats;
+		const char u = i.second.has_time_units ? 's' : ' ';
+		const string sMinT = unitsFormat(st.min_t, 1, false);
+		const string sMaxT = unitsFormat(st.max_t, 1, false);
+		const string sTotalT = unitsFormat(st.total_t, 1, false);
+		const string sMeanT = unitsFormat(st.mean_t, 1, false);
 
 		stats_text += format(
 			"%s %7u %6s%c %6s%c %6s%c %6s%c\n",
 			aux_format_string_multilines(i.first, 39).c_str(),
-			static_cast<unsigned int>(i.second.n_calls), sMinT.c_str(),
-			i.second.has_time_units ? 's' : ' ', sMeanT.c_str(),
-			i.second.has_time_units ? 's' : ' ', sMaxT.c_str(),
-			i.second.has_time_units ? 's' : ' ', sTotalT.c_str(),
-			i.second.has_time_units ? 's' : ' ');
+			static_cast<unsigned int>(st.n_calls), sMinT.c_str(), u,
+			sMeanT.c_str(), u, sMaxT.c_str(), u, sTotalT.c_str(), u);
 	}
 
 	std::string footer(top_header);
@@ -192,18 +603,74 @@ void CTimeLogger::saveToCSVFile(const std::string& csv_file) const
 {
 	std::string s;
 	s += "FUNCTION, #CALLS, LAST.T, MIN.T, MEAN.T, MAX.T, TOTAL.T\n";
-	for (const auto& i : m_data)
+	for (const auto& i : m_impl->allMergedStats())
 	{
+		const TCallStats& st = i.second.stats;
 		s += format(
 			"\"%s\",\"%7u\",\"%e\",\"%e\",\"%e\",\"%e\",\"%e\"\n",
-			i.first.c_str(), static_cast<unsigned int>(i.second.n_calls),
-			i.second.last_t, i.second.min_t,
-			i.second.n_calls ? i.second.mean_t / i.second.n_calls : 0,
-			i.second.max_t, i.second.mean_t);
+			i.first.c_str(), static_cast<unsigned int>(st.n_calls), st.last_t,
+			st.min_t, st.mean_t, st.max_t, st.total_t);
 	}
 	std::ofstream(csv_file) << s;
 }
 
+// Escapes a string for JSON:
+static std::string json_escape(const std::string& s)
+{
+	std::string r;
+	r.reserve(s.size());
+	for (const char c : s)
+	{
+		if (c == '"' || c == '\\')
+		{
+			r += '\\';
+			r += c;
+		}
+		else if (static_cast<unsigned char>(c) < 0x20)
+			r += format("\\u%04x", static_cast<unsigned int>(c));
+		else
+			r += c;
+	}
+	return r;
+}
+
+void CTimeLogger::saveToChromeTraceFile(const std::string& json_file) const
+{
+	const Impl& d = *m_impl;
+	std::ofstream f(json_file);
+	if (!f.is_open())
+		THROW_EXCEPTION_FMT("Error creating file: `%s`", json_file.c_str());
+
+	std::lock_guard<std::mutex> lck(d.mtx);
+	std::vector<std::string> names;
+	for (const auto& n : d.names) names.push_back(json_escape(n));
+
+	f << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+	f << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,"
+		 "\"args\":{\"name\":\""
+	  << json_escape(m_name.empty() ? std::string("CTimeLogger") : m_name)
+	  << "\"}}";
+	for (const auto& t : d.threads)
+	{
+		f << format(
+			",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,"
+			"\"tid\":%u,\"args\":{\"name\":\"thread #%u\"}}",
+			t->tid, t->tid);
+		// "Complete" events, with timestamps in microseconds:
+		t->forEachEvent([&](const TEvent& ev) {
+			if (ev.id >= names.size()) return;
+			f << ",\n{\"name\":\"" << names[ev.id]
+			  << format(
+					 "\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,"
+					 "\"dur\":%.3f}",
+					 t->tid, (ev.t0 - d.t0) * 1e-3, (ev.t1 - ev.t0) * 1e-3);
+		});
+	}
+	f << "\n]}\n";
+	if (!f.good())
+		THROW_EXCEPTION_FMT("Error writing file: `%s`", json_file.c_str());
+}
+
 void CTimeLogger::dumpAllStats(const size_t column_width) const
 {
 	MRPT_LOG_INFO_STREAM("dumpAllStats:\n" << getStatsAsText(column_width));
@@ -211,86 +678,49 @@ void CTimeLogger::dumpAllStats(const size_t column_width) const
 
 void CTimeLogger::do_enter(const char* func_name)
 {
-	const string s = func_name;
-	TCallData& d = m_data[s];
-
-	d.n_calls++;
-	d.open_calls.push(0);  // Dummy value, it'll be written below
-	d.open_calls.top() = m_tictac.Tac();  // to avoid possible delays.
+	Impl& d = *m_impl;
+	d.enter(d.sectionID(*d.threadData(), func_name));
 }
 
 double CTimeLogger::do_leave(const char* func_name)
 {
-	const double tim = m_tictac.Tac();
-
-	const string s = func_name;
-	TCallData& d = m_data[s];
-
-	if (!d.open_calls.empty())
-	{
-		const double At = tim - d.open_calls.top();
-		d.open_calls.pop();
+	Impl& d = *m_impl;
+	return d.leave(d.sectionID(*d.threadData(), func_name));
+}
 
-		d.last_t = At;
-		d.mean_t += At;
-		if (d.n_calls == 1)
-		{
-			d.min_t = At;
-			d.max_t = At;
-		}
-		else
-		{
-			mrpt::keep_min(d.min_t, At);
-			mrpt::keep_max(d.max_t, At);
-		}
-		return At;
-	}
-	else
-		return 0;  // This shouldn't happen!
+void CTimeLogger::do_enter(TSectionID id)
+{
+	m_impl->enter(static_cast<uint32_t>(id));
+}
+double CTimeLogger::do_leave(TSectionID id)
+{
+	return m_impl->leave(static_cast<uint32_t>(id));
 }
 
 void CTimeLogger::registerUserMeasure(
 	const char* event_name, const double value)
 {
 	if (!m_enabled) return;
-	const string s = event_name;
-	TCallData& d = m_data[s];
-
-	d.has_time_units = false;
-	d.last_t = value;
-	d.mean_t += value;
-	if (++d.n_calls == 1)
-	{
-		d.min_t = value;
-		d.max_t = value;
-	}
-	else
-	{
-		mrpt::keep_min(d.min_t, value);
-		mrpt::keep_max(d.max_t, value);
-	}
-}
-
-CTimeLogger::TCallData::TCallData()
-	: n_calls(0), min_t(0), max_t(0), mean_t(0), last_t(0), has_time_units(true)
-{
+	Impl& d = *m_impl;
+	TThreadData& td = *d.threadData();
+	TSectionStats& st = td.stats(d.sectionID(td, event_name));
+	st.has_time_units.store(false, std::memory_order_relaxed);
+	st.add(value, now_ns());
 }
 
 double CTimeLogger::getMeanTime(const std::string& name) const
 {
-	TDataMap::const_iterator it = m_data.find(name);
-	if (it == m_data.end())
-		return 0;
-	else
-		return it->second.n_calls ? it->second.mean_t / it->second.n_calls : 0;
+	const Impl& d = *m_impl;
+	std::lock_guard<std::mutex> lck(d.mtx);
+	const auto it = d.name2id.find(name);
+	return it == d.name2id.end() ? 0 : d.mergedStats(it->second).stats.mean_t;
 }
 double CTimeLogger::getLastTime(const std::string& name) const
 {
-	TDataMap::const_iterator it = m_data.find(name);
-	if (it == m_data.end())
-		return 0;
-	else
-		return it->second.last_t;
+	const Impl& d = *m_impl;
+	std::lock_guard<std::mutex> lck(d.mtx);
+	const auto it = d.name2id.find(name);
+	return it == d.name2id.end() ? 0 : d.mergedStats(it->second).stats.last_t;
 }
 
 CTimeLoggerEntry::CTimeLoggerEntry(
@@ -0,0 +1,159 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/system/CTimeLogger.h>
+#include <mrpt/system/filesystem.h>
+#include <gtest/gtest.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using mrpt::system::CTimeLogger;
+using mrpt::system::CTimeLoggerEntry;
+
+TEST(CTimeLogger, nestedAndRecursiveSections)
+{
+	CTimeLogger tl(true, "test");
+	tl.setMinLoggingLevel(mrpt::system::LVL_ERROR);
+	for (int i = 0; i < 10; i++)
+	{
+		CTimeLoggerEntry e1(tl, "outer");
+		tl.enter("rec");
+		tl.enter("rec");
+		tl.leave("rec");
+		tl.leave("rec");
+	}
+	std::map<std::string, CTimeLogger::TCallStats> st;
+	tl.getStats(st);
+	ASSERT_EQ(st.size(), 2u);
+	EXPECT_EQ(st["outer"].n_calls, 10u);
+	EXPECT_EQ(st["rec"].n_calls, 20u);
+	EXPECT_GE(st["outer"].total_t, st["rec"].total_t);
+	EXPECT_NEAR(st["rec"].mean_t * 20, st["rec"].total_t, 1e-12);
+	EXPECT_LE(st["rec"].min_t, st["rec"].max_t);
+
+	// Non-literal names, at the same address, must not be confused:
+	char name[16];
+	strcpy(name, "dyn1");
+	tl.enter(name);
+	tl.leave(name);
+	strcpy(name, "dyn2");
+	tl.enter(name);
+	tl.leave(name);
+	tl.getStats(st);
+	EXPECT_EQ(st["dyn1"].n_calls, 1u);
+	EXPECT_EQ(st["dyn2"].n_calls, 1u);
+
+	// Unbalanced leave() is ignored:
+	EXPECT_EQ(tl.leave("outer"), 0.0);
+}
+
+TEST(CTimeLogger, sectionIDs)
+{
+	CTimeLogger tl;
+	tl.setMinLoggingLevel(mrpt::system::LVL_ERROR);
+	const auto id = tl.getSectionID("fast");
+	EXPECT_TRUE(id == tl.getSectionID("fast"));
+	for (int i = 0; i < 5; i++)
+	{
+		tl.enter(id);
+		tl.leave("fast");  // Names and IDs can be mixed
+	}
+	std::map<std::string, CTimeLogger::TCallStats> st;
+	tl.getStats(st);
+	EXPECT_EQ(st["fast"].n_calls, 5u);
+
+	tl.clear();
+	tl.getStats(st);
+	EXPECT_EQ(st["fast"].n_calls, 0u);
+	tl.clear(true);
+	tl.getStats(st);
+	EXPECT_TRUE(st.empty());
+}
+
+TEST(CTimeLogger, multiThreaded)
+{
+	CTimeLogger tl;
+	tl.setMinLoggingLevel(mrpt::system::LVL_ERROR);
+	const int nThreads = 4, nCalls = 2000;
+	std::vector<std::thread> ths;
+	for (int t = 0; t < nThreads; t++)
+		ths.emplace_back([&tl, t]() {
+			for (int i = 0; i < nCalls; i++)
+			{
+				CTimeLoggerEntry e(tl, "common");
+				tl.enter(t % 2 ? "odd" : "even");
+				tl.leave(t % 2 ? "odd" : "even");
+			}
+			tl.registerUserMeasure("value", t);
+		});
+	for (auto& th : ths) th.join();
+
+	std::map<std::string, CTimeLogger::TCallStats> st;
+	tl.getStats(st);
+	EXPECT_EQ(st["common"].n_calls, size_t(nThreads * nCalls));
+	EXPECT_EQ(st["odd"].n_calls, size_t(nThreads / 2 * nCalls));
+	EXPECT_EQ(st["even"].n_calls, size_t(nThreads / 2 * nCalls));
+	EXPECT_EQ(st["value"].n_calls, size_t(nThreads));
+	EXPECT_EQ(st["value"].min_t, 0.0);
+	EXPECT_EQ(st["value"].max_t, nThreads - 1.0);
+
+	// Copies keep the stats:
+	CTimeLogger tl2 = tl;
+	std::map<std::string, CTimeLogger::TCallStats> st2;
+	tl2.getStats(st2);
+	EXPECT_EQ(st2["common"].n_calls, st["common"].n_calls);
+	EXPECT_EQ(st2["common"].total_t, st["common"].total_t);
+}
+
+TEST(CTimeLogger, reports)
+{
+	CTimeLogger tl(true, "reports");
+	tl.setMinLoggingLevel(mrpt::system::LVL_ERROR);
+	tl.enableEventTrace();
+	EXPECT_TRUE(tl.isEventTraceEnabled());
+	for (int i = 0; i < 3; i++)
+	{
+		CTimeLoggerEntry e(tl, "sec\"A\"");
+	}
+	std::thread([&tl]() { CTimeLoggerEntry e(tl, "secB"); }).join();
+
+	const std::string txt = tl.getStatsAsText();
+	EXPECT_NE(txt.find("secB"), std::string::npos);
+
+	const std::string csvFile = mrpt::system::getTempFileName() + ".csv";
+	tl.saveToCSVFile(csvFile);
+	{
+		std::ifstream f(csvFile);
+		std::string line;
+		int nLines = 0;
+		while (std::getline(f, line)) nLines++;
+		EXPECT_EQ(nLines, 3);  // header + 2 sections
+	}
+	mrpt::system::deleteFile(csvFile);
+
+	const std::string jsonFile = mrpt::system::getTempFileName() + ".json";
+	tl.saveToChromeTraceFile(jsonFile);
+	{
+		std::ifstream f(jsonFile);
+		std::stringstream ss;
+		ss << f.rdbuf();
+		const std::string json = ss.str();
+		size_t nEvents = 0;
+		for (size_t p = json.find("\"ph\":\"X\""); p != std::string::npos;
+			 p = json.find("\"ph\":\"X\"", p + 1))
+			nEvents++;
+		EXPECT_EQ(nEvents, 4u);
+		EXPECT_NE(json.find("\"name\":\"sec\\\"A\\\"\""), std::string::npos);
+		EXPECT_NE(json.find("\"tid\":1"), std::string::npos);
+		EXPECT_EQ(json.substr(json.size() - 3), "]}\n");
+	}
+	mrpt::system::deleteFile(jsonFile);
+}
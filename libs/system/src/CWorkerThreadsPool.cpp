@@ -0,0 +1,65 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include "system-precomp.h"  // Precompiled headers
+
+#include <mrpt/system/CWorkerThreadsPool.h>
+#include <algorithm>
+
+using namespace mrpt::system;
+
+CWorkerThreadsPool::CWorkerThreadsPool(std::size_t num_threads)
+{
+	if (num_threads == 0)
+		num_threads =
+			std::max<std::size_t>(1, std::thread::hardware_concurrency());
+
+	for (std::size_t i = 0; i < num_threads; i++)
+	{
+		m_threads.emplace_back([this]() {
+			for (;;)
+			{
+				std::function<void()> task;
+				{
+					std::unique_lock<std::mutex> lock(m_queue_mutex);
+					m_condition.wait(lock, [this]() {
+						return m_do_stop || !m_tasks.empty();
+					});
+					if (m_do_stop) return;
+					task = std::move(m_tasks.front());
+					m_tasks.pop();
+				}
+				task();
+			}
+		});
+	}
+}
+
+CWorkerThreadsPool::~CWorkerThreadsPool() { clear(); }
+void CWorkerThreadsPool::clear()
+{
+	{
+		std::unique_lock<std::mutex> lock(m_queue_mutex);
+		m_do_stop = true;
+		// Destroying the packaged tasks breaks their promises:
+		std::queue<std::function<void()>>().swap(m_tasks);
+	}
+	m_condition.notify_all();
+
+	for (auto& t : m_threads)
+		if (t.joinable()) t.join();
+	m_threads.clear();
+}
+
+std::size_t CWorkerThreadsPool::size() const { return m_threads.size(); }
+std::size_t CWorkerThreadsPool::pendingTasks() const noexcept
+{
+	std::unique_lock<std::mutex> lock(m_queue_mutex);
+	return m_tasks.size();
+}
@@ -0,0 +1,53 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/system/CWorkerThreadsPool.h>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <stdexcept>
+
+TEST(CWorkerThreadsPool, enqueue)
+{
+	mrpt::system::CWorkerThreadsPool pool(3);
+	EXPECT_EQ(pool.size(), 3u);
+
+	std::vector<std::future<int>> futs;
+	for (int i = 0; i < 100; i++)
+		futs.push_back(pool.enqueue([](int a) { return 2 * a; }, i));
+
+	for (int i = 0; i < 100; i++) EXPECT_EQ(futs[i].get(), 2 * i);
+}
+
+TEST(CWorkerThreadsPool, allTasksRun)
+{
+	std::atomic<int> cnt{0};
+	{
+		mrpt::system::CWorkerThreadsPool pool(2);
+		std::vector<std::future<void>> futs;
+		for (int i = 0; i < 1000; i++)
+			futs.push_back(pool.enqueue([&cnt]() { cnt++; }));
+		for (auto& f : futs) f.get();
+	}
+	EXPECT_EQ(cnt.load(), 1000);
+}
+
+TEST(CWorkerThreadsPool, exceptions)
+{
+	mrpt::system::CWorkerThreadsPool pool(1);
+	auto fut = pool.enqueue([]() { throw std::runtime_error("test"); });
+	EXPECT_THROW(fut.get(), std::runtime_error);
+}
+
+TEST(CWorkerThreadsPool, enqueueAfterClearThrows)
+{
+	mrpt::system::CWorkerThreadsPool pool(2);
+	pool.clear();
+	EXPECT_EQ(pool.size(), 0u);
+	EXPECT_ANY_THROW(pool.enqueue([]() {}));
+}